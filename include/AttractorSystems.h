@@ -0,0 +1,130 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ The chaotic systems LorenzSolver can integrate, besides the Lorenz
+ equations themselves.
+
+ Each system is a small functor: its parameters are plain members,
+ copied from the solver's parameter pack when the functor is made, and
+ operator() is the right hand side du/dt = f(u), in the precision of u
+ (float for the solver, double for PararealSolver). The integration
+ kernels are templates over the functor, instantiated once per system,
+ so f() inlines into the RK4 loop and the system is chosen once per
+ solve, not once per step.
+
+ Each functor also carries its traits, for the UI: its name, the name,
+ default and range of each of its NUM_PARAMS parameters, a starting point
+ near the attractor and an integration step that resolves the flow well
+ with RK4 (defined in AttractorSystems.cpp). getAttractorInfo() gathers
+ them by system, so the params panel is built from the traits.
+
+ */
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Vector.h"
+#include <math.h>
+#include <stddef.h>
+
+#define ATTRACTOR_MAX_PARAMS    3
+
+
+enum AttractorSystem {
+    ATTRACTOR_LORENZ,
+    ATTRACTOR_ROSSLER,
+    ATTRACTOR_CHEN,
+    ATTRACTOR_THOMAS,
+    ATTRACTOR_HALVORSEN,
+    ATTRACTOR_COUNT
+};
+
+struct AttractorParam {
+    const char  *mName;
+    float       mDefault, mMin, mMax, mStep;
+};
+
+struct AttractorInfo {
+    const char              *mName;
+    size_t                  mNumParams;
+    const AttractorParam    *mParams;       // mNumParams of them
+    ci::Vec3f               mInitialCondition;      // near the attractor
+    float                   mH;                     // integration step
+};
+
+const AttractorInfo&    getAttractorInfo( AttractorSystem system );
+
+
+// dx = S(y - x),  dy = x(R - z) - y,  dz = xy - Bz
+struct LorenzSystem {
+    enum { NUM_PARAMS = 3 };
+    static const char           *sName;
+    static const AttractorParam sParams[NUM_PARAMS];
+    static const ci::Vec3f      sInitialCondition;
+    static const float          sH;
+    float s, r, b;
+    explicit LorenzSystem( const float *p ) : s(p[0]), r(p[1]), b(p[2]) {}
+    template<typename T> ci::Vec3<T> operator()( const ci::Vec3<T> &u ) const {
+        return ci::Vec3<T>( s * (u.y - u.x), -u.x * u.z + r * u.x - u.y, u.x * u.y - b * u.z );
+    }
+};
+
+// dx = -y - z,  dy = x + ay,  dz = b + z(x - c)
+struct RosslerSystem {
+    enum { NUM_PARAMS = 3 };
+    static const char           *sName;
+    static const AttractorParam sParams[NUM_PARAMS];
+    static const ci::Vec3f      sInitialCondition;
+    static const float          sH;
+    float a, b, c;
+    explicit RosslerSystem( const float *p ) : a(p[0]), b(p[1]), c(p[2]) {}
+    template<typename T> ci::Vec3<T> operator()( const ci::Vec3<T> &u ) const {
+        return ci::Vec3<T>( -u.y - u.z, u.x + a * u.y, b + u.z * (u.x - c) );
+    }
+};
+
+// dx = a(y - x),  dy = (c - a)x - xz + cy,  dz = xy - bz
+struct ChenSystem {
+    enum { NUM_PARAMS = 3 };
+    static const char           *sName;
+    static const AttractorParam sParams[NUM_PARAMS];
+    static const ci::Vec3f      sInitialCondition;
+    static const float          sH;
+    float a, b, c;
+    explicit ChenSystem( const float *p ) : a(p[0]), b(p[1]), c(p[2]) {}
+    template<typename T> ci::Vec3<T> operator()( const ci::Vec3<T> &u ) const {
+        return ci::Vec3<T>( a * (u.y - u.x), (c - a) * u.x - u.x * u.z + c * u.y, u.x * u.y - b * u.z );
+    }
+};
+
+// dx = sin(y) - bx,  dy = sin(z) - by,  dz = sin(x) - bz
+struct ThomasSystem {
+    enum { NUM_PARAMS = 1 };
+    static const char           *sName;
+    static const AttractorParam sParams[NUM_PARAMS];
+    static const ci::Vec3f      sInitialCondition;
+    static const float          sH;
+    float b;
+    explicit ThomasSystem( const float *p ) : b(p[0]) {}
+    template<typename T> ci::Vec3<T> operator()( const ci::Vec3<T> &u ) const {
+        return ci::Vec3<T>( sin( u.y ) - b * u.x, sin( u.z ) - b * u.y, sin( u.x ) - b * u.z );
+    }
+};
+
+// dx = -ax - 4y - 4z - y^2, and cyclically for y and z
+struct HalvorsenSystem {
+    enum { NUM_PARAMS = 1 };
+    static const char           *sName;
+    static const AttractorParam sParams[NUM_PARAMS];
+    static const ci::Vec3f      sInitialCondition;
+    static const float          sH;
+    float a;
+    explicit HalvorsenSystem( const float *p ) : a(p[0]) {}
+    template<typename T> ci::Vec3<T> operator()( const ci::Vec3<T> &u ) const {
+        return ci::Vec3<T>( -a * u.x - 4.0f * (u.y + u.z) - u.y * u.y,
+                          -a * u.y - 4.0f * (u.z + u.x) - u.z * u.z,
+                          -a * u.z - 4.0f * (u.x + u.y) - u.x * u.x );
+    }
+};
@@ -0,0 +1,64 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ The purpose of this class is to render an ensemble of K trajectories,
+ started from nearby initial conditions, in a single draw call.
+
+ All trajectories share one index buffer, built for the spheres of one
+ trajectory. Trajectory k owns the k'th block of vertices; it is drawn
+ from that shared index set with base vertex k * (vertices per trajectory),
+ and every trajectory has its own draw range (first step, number of steps).
+ The K ranges go to the GPU as one glMultiDrawElementsBaseVertex call.
+
+ Vertex data is split in a static buffer (normals and the per-trajectory
+ color) written once, and a dynamic buffer holding only the positions.
+
+ */
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Vbo.h"
+#include "cinder/Color.h"
+#include "cinder/Vector.h"
+#include <vector>
+#include <stdint.h>
+
+#include "SphereMeshModel.h"
+
+
+class EnsembleMesh
+{
+    struct StaticVertex {
+        ci::Vec3f   mNormal;
+        ci::ColorA8u mColor;
+    };
+
+    SphereMeshModel         mSphereModel;
+    size_t                  mMaxTrajectories;
+    size_t                  mStepsPerTrajectory;
+    size_t                  mNumTrajectories;       // currently drawn
+    uint32_t                mVerticesPerTrajectory;
+    ci::gl::Vbo             mIndexVbo, mStaticVbo, mDynamicVbo;
+    std::vector<GLsizei>    mCounts;                // per-trajectory draw ranges, in indices
+    std::vector<const GLvoid*> mOffsets;            // ...and their start, as byte offset in the index buffer
+    std::vector<GLint>      mBaseVertices;
+
+public:
+
+    EnsembleMesh() : mMaxTrajectories(0), mStepsPerTrajectory(0), mNumTrajectories(0), mVerticesPerTrajectory(0) {}
+
+    void    init( size_t maxTrajectories, size_t stepsPerTrajectory, const SphereMeshModel &sphereModel );
+    void    updatePositions( const std::vector<ci::Vec3f> &centers, size_t numTrajectories );
+    void    setDrawRange( size_t trajectory, size_t firstStep, size_t numSteps );
+    void    draw();
+    size_t  getMaxTrajectories() const { return mMaxTrajectories; }
+    bool    isInitialized() const { return mMaxTrajectories > 0; }
+
+private:
+
+    void    setPointers( size_t baseVertex );
+};
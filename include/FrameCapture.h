@@ -0,0 +1,87 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ The purpose of this class is to record the rendered frames into an
+ image sequence without stalling the render loop.
+
+ Each frame is read back into one of a small ring of pixel-pack buffers
+ (PBOs). glReadPixels into a PBO returns immediately; the buffer is mapped
+ only CAPTURE_NUM_PBOS-1 frames later, when the GPU is done with it. The
+ pixels are then handed to an encoder thread that writes PNG files or
+ one raw RGBA stream. No frame is ever dropped: when the encoder falls
+ behind, captureFrame() waits for a free queue slot (backpressure).
+
+ */
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Vbo.h"
+#include "cinder/Surface.h"
+#include "cinder/Filesystem.h"
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+
+#define CAPTURE_NUM_PBOS    3   // PBOs in the read-back ring
+#define CAPTURE_QUEUE_SIZE  8   // frames waiting for the encoder before the render loop is held
+
+
+class FrameCapture
+{
+public:
+
+    enum Format { FORMAT_PNG, FORMAT_RAW };
+
+    FrameCapture();
+    ~FrameCapture();
+
+    void    start( const ci::fs::path &directory, int32_t width, int32_t height, Format format=FORMAT_PNG );
+    void    captureFrame();     // call once per frame, after rendering, with the source framebuffer bound
+    void    stop();             // flushes the ring and the queue, then joins the encoder
+    bool    isCapturing() const { return mIsCapturing; }
+    size_t  getFramesCaptured() const { return mFramesCaptured; }
+    size_t  getFramesWritten();
+    size_t  getBackpressureWaits() const { return mBackpressureWaits; }
+
+private:
+
+    struct Frame {
+        ci::Surface8u   mSurface;
+        size_t          mNumber;
+    };
+
+    FrameCapture( const FrameCapture& );            // not copyable: owns a thread
+    FrameCapture& operator=( const FrameCapture& );
+
+    void    readBack( size_t slot );
+    void    enqueue( const Frame &frame );
+    void    encoderLoop();
+    void    writeFrame( Frame &frame );
+
+    ci::fs::path            mDirectory;
+    int32_t                 mWidth, mHeight;
+    Format                  mFormat;
+    bool                    mIsCapturing;
+
+    std::vector<ci::gl::Vbo> mPbos;
+    std::vector<bool>       mPboPending;
+    std::vector<size_t>     mPboFrame;
+    size_t                  mFramesCaptured;
+    size_t                  mBackpressureWaits;
+
+    std::thread             mEncoder;
+    std::mutex              mMutex;
+    std::condition_variable mQueueNotEmpty, mQueueNotFull;
+    std::deque<Frame>       mQueue;
+    bool                    mStopEncoder;
+    size_t                  mFramesWritten;
+    std::ofstream           mRawStream;
+};
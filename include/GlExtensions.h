@@ -0,0 +1,70 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ OpenGL entry points newer than the GL headers that come with Cinder 0.8.5.
+ They are looked up once from the current context by glext::init(); the
+ has*() queries tell whether the context really supports the feature,
+ and callers keep a plain OpenGL path for when it does not.
+
+ */
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT               0x140B
+#endif
+#ifndef GL_INT_2_10_10_10_REV
+#define GL_INT_2_10_10_10_REV       0x8D9F
+#endif
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT            0x0002
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT       0x0040
+#define GL_MAP_COHERENT_BIT         0x0080
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE   0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT      0x0001
+#define GL_ALREADY_SIGNALED         0x911A
+#define GL_TIMEOUT_EXPIRED          0x911B
+#define GL_CONDITION_SATISFIED      0x911C
+#define GL_WAIT_FAILED              0x911D
+#endif
+
+
+namespace glext {
+
+    struct  SyncObject;
+    typedef SyncObject* Sync;   // GLsync
+
+    void    init();     // call once, with the GL context current
+
+    // GL 3.2 / ARB_draw_elements_base_vertex
+    bool    hasDrawElementsBaseVertex();
+    void    drawElementsBaseVertex( GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLint baseVertex );
+    void    multiDrawElementsBaseVertex( GLenum mode, const GLsizei *counts, GLenum type, const GLvoid **indices, GLsizei drawCount, const GLint *baseVertices );
+
+    // Vertex attribute types; no new entry points, only new enums
+    bool    hasHalfFloatVertex();                   // GL 3.0 / ARB_half_float_vertex
+    bool    hasVertexType2_10_10_10_Rev();          // GL 3.3 / ARB_vertex_type_2_10_10_10_rev
+
+    // GL 4.4 / ARB_buffer_storage, and GL 3.0 / ARB_map_buffer_range to map such a buffer
+    bool    hasBufferStorage();
+    void    bufferStorage( GLenum target, size_t size, const GLvoid *data, GLbitfield flags );
+    void*   mapBufferRange( GLenum target, size_t offset, size_t length, GLbitfield access );
+
+    // GL 3.2 / ARB_sync
+    bool    hasSync();
+    Sync    fenceSync( GLenum condition, GLbitfield flags );
+    GLenum  clientWaitSync( Sync sync, GLbitfield flags, uint64_t timeout );
+    void    deleteSync( Sync sync );
+
+}
@@ -0,0 +1,97 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ The purpose of this class is to measure the accuracy versus cost of
+ the integrators in LorenzSolver, so that the {STRIDE,H} defaults can
+ be chosen from data.
+
+ Each integrator is run over a grid of H values and compared, at fixed
+ sample times, with a double precision RK4 reference taken at a much
+ smaller step. A chaotic trajectory computed in float can only follow
+ the reference for a limited time (the predictability horizon, roughly
+ 15 time units for the default parameters), so the error is taken over
+ the first HARNESS_ERROR_SPAN time units, well inside it. How long the
+ result stays within HARNESS_LOST_DISTANCE of the reference is reported
+ separately as the "valid time".
+
+ Integrators with automatic step size (Taylor) do not depend on H; they
+ are run over a grid of tolerances instead, with output every sample.
+
+ For each run: max error, RHS evaluations and wall time per time unit.
+ The Taylor integrator evaluates no RHS; its cost is its multiplies,
+ converted to RK4 RHS evaluations of the same number of multiplies (see
+ LorenzSolver::solveTaylor()), so that the orders compare fairly.
+ The runs that no other run beats on both error and RHS evaluations
+ form the Pareto front. printMatchedError() compares each run with the
+ cheapest run of a baseline integrator reaching at least the same error.
+
+ */
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Vector.h"
+#include "cinder/Filesystem.h"
+#include <vector>
+#include <string>
+#include <ostream>
+#include <functional>
+
+#include "LorenzSolver.h"
+
+#define HARNESS_SAMPLE_INTERVAL 0.05    // time between compared points; every H divides it
+#define HARNESS_ERROR_SPAN      10.0    // time span the error is measured over
+#define HARNESS_TRACK_SPAN      30.0    // time span the "valid time" is looked for in
+#define HARNESS_REFERENCE_H     1.0e-5  // step of the double precision reference
+#define HARNESS_LOST_DISTANCE   1.0     // the trajectory is considered lost beyond this error
+#define HARNESS_MIN_WALL_TIME   0.05    // seconds; short runs are repeated up to this
+
+
+class IntegratorHarness
+{
+public:
+
+    struct Result {
+        std::string mIntegrator;
+        double      mH;
+        double      mTolerance;         // automatic step size only, else 0
+        bool        mIsStable;
+        double      mMaxError;          // over HARNESS_ERROR_SPAN
+        double      mValidTime;         // until the error first exceeds HARNESS_LOST_DISTANCE
+        double      mRhsPerTime;        // RHS evaluations per time unit
+        double      mWallPerTime;       // seconds per time unit
+        bool        mIsPareto;
+    };
+
+    IntegratorHarness( float s, float r, float b, const ci::Vec3f &initCondition );
+
+    void    addIntegrator( const std::string &name, const std::function<void (LorenzSolver&)> &configure );
+    void    addAdaptiveIntegrator( const std::string &name, const std::function<void (LorenzSolver&, double)> &configure );
+    void    addDefaultIntegrators();
+    void    run( std::ostream &log );
+    void    printTable( std::ostream &out ) const;
+    void    printMatchedError( std::ostream &out, const std::string &baseline ) const;
+    void    writeCsv( const ci::fs::path &path ) const;
+    void    writeGnuplot( const ci::fs::path &scriptPath, const ci::fs::path &csvPath, const ci::fs::path &plotPath ) const;
+    const std::vector<Result>& getResults() const { return mResults; }
+
+private:
+
+    struct Integrator {
+        std::string mName;
+        std::function<void (LorenzSolver&)> mConfigure;
+        std::function<void (LorenzSolver&, double)> mConfigureAdaptive;   // given the tolerance
+    };
+
+    void    computeReference( double h, std::vector<ci::Vec3d> &samples ) const;
+    Result  measure( const Integrator &integrator, size_t stepsPerSample, double tolerance ) const;
+    void    markPareto();
+
+    float                   mS, mR, mB;
+    ci::Vec3f               mInitCondition;
+    std::vector<Integrator> mIntegrators;
+    std::vector<ci::Vec3d>  mReference;         // at every HARNESS_SAMPLE_INTERVAL
+    std::vector<Result>     mResults;
+};
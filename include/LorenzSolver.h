@@ -7,14 +7,25 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
+#include <stdint.h>
 #include "cinder/Cinder.h"
 #include "cinder/Vector.h"
 
+#include "AttractorSystems.h"
+
 #define DEFAULT_PAR_S   10.0f   // default param sigma
 #define DEFAULT_PAR_R   30.0f   // default param r
 #define DEFAULT_PAR_B   3.0f    // default param b
 #define DEFAULT_H       0.01f   // Integration step
 #define DEFAULT_STRIDE  1       // See below
+#define DEFAULT_TAYLOR_ORDER     20      // Taylor integrator, see below
+#define DEFAULT_TAYLOR_TOLERANCE 1e-10   // local error per step, relative to |u| (when > 1)
+#define TAYLOR_MAX_ORDER         40
+#define TAYLOR_MAX_STEP          1.0     // upper bound on the automatic step size
+#define TAYLOR_MULTIPLIES_PER_RHS 10     // an RK4 step of the Lorenz system: 4 RHS of 5 multiplies, 18 to combine them
+#define DEFAULT_SAMPLE_SPACING   0.5f    // adaptive sampling, see below
+#define CURVATURE_MAX_SPACING    8.0f    // ...times the spacing, the longest gap of the curvature criterion
 
 // Tweaking the {STRIDE,H} combination can be used to reduce the integration 
 // step and visualize only each N'th solution. This allows for exploring the 
@@ -28,41 +39,97 @@
 //
 // *NOTE*: Increasing DEFAULT_H above 0.01 can lead quickly to getting of the 
 // range of stability and unexpected/unbounded results.
+//
+// The Taylor-series integrator is not bound to H: it picks its own step
+// size from the tolerance, usually far larger than H, and evaluates the
+// series at the output times (every STRIDE*H). It runs in double precision.
+//
+// Adaptive sampling picks the rendered points from the solutions by arc
+// length instead of every STRIDE'th step: the flow is slow near the fixed 
+// points and fast on the lobes, so the fixed stride piles points up in 
+// the former and spreads them in the latter. SAMPLING_ARC_LENGTH keeps a
+// point every "spacing" of arc length; SAMPLING_CURVATURE keeps one when 
+// the path since the last point deviates from the straight chord by more 
+// than the tolerance, or at the latest after CURVATURE_MAX_SPACING times
+// "spacing", so that straight stretches thin out. The last solution is
+// always a sample. Each sample keeps its step index, for coloring by time.
+//
+// Besides the Lorenz equations the solver integrates the other systems
+// of AttractorSystems.h, chosen by setSystem() with their parameters. 
+// The Euler and RK4 kernels are templates instantiated per system; the 
+// Taylor integrator has the Lorenz recurrence only, so with another 
+// system it falls back to RK4.
+//
+// IntegratorHarness measures the error, cost and time of each integrator
+// over a range of H against a high precision reference, for choosing
+// these settings from data.
 
 class LorenzSolver
 {
+public:
+
+    enum Integrator { INTEGRATOR_EULER, INTEGRATOR_RK4, INTEGRATOR_TAYLOR };
+    enum Sampling { SAMPLING_STRIDE, SAMPLING_ARC_LENGTH, SAMPLING_CURVATURE };
+
 private:
 
     size_t      mNumPositions;
-    ci::Vec3f   mU0, mU1, mOriginalInitCondition, mInitCondition;
-    float       mS, mR, mB, mH;
+    ci::Vec3f   mOriginalInitCondition, mInitCondition;
+    AttractorSystem mSystem;
+    float       mParams[ATTRACTOR_MAX_PARAMS];
+    float       mH;
     size_t      mStride;
-    bool        mUseRK4;
+    Integrator  mIntegrator;
+    int         mTaylorOrder;
+    double      mTaylorTolerance;
+    Sampling    mSampling;
+    float       mSampleSpacing, mSampleTolerance;
     ci::Vec3f   mMinPos, mMaxPos, mCenterPos;
     bool        mIsCenterCalculated;
+    size_t      mRhsEvaluations;    // by the last solve()
 
 public:
 
     std::vector<ci::Vec3f> mSolutions;
+    std::vector<ci::Vec3f> mSamples;        // adaptive sampling only
+    std::vector<uint32_t>  mSampleSteps;    // ...the step index of each sample
 
     LorenzSolver() {};
     LorenzSolver( size_t numPositions, ci::Vec3f initCondition, float H=DEFAULT_H, float pS=DEFAULT_PAR_S, float pR=DEFAULT_PAR_R, float pB=DEFAULT_PAR_B ) :
-                  mNumPositions(numPositions), mS(pS), mR(pR), mB(pB), mH(H), mOriginalInitCondition(initCondition), mStride(DEFAULT_STRIDE)  { initOnce(); }
-    void        setParameters( float s, float r, float b ) { mS = s; mR = r; mB = b; }
+                  mNumPositions(numPositions), mSystem(ATTRACTOR_LORENZ), mH(H), mOriginalInitCondition(initCondition), mStride(DEFAULT_STRIDE)  { setParameters( pS, pR, pB ); initOnce(); }
+    void        setParameters( float s, float r, float b );     // of the Lorenz system
+    void        setSystem( AttractorSystem system, const float *params );
+    AttractorSystem getSystem() const { return mSystem; }
     void        setIntegrationStep( float h, size_t stride=DEFAULT_STRIDE ) { mH = h; mStride = stride; }
     void        setInitialConditions( ci::Vec3f xyz ) { mInitCondition = xyz; }
-    void        useRK4(bool b) { mUseRK4 = b; }
+    void        useRK4(bool b) { mIntegrator = b ? INTEGRATOR_RK4 : INTEGRATOR_EULER; }
+    void        setIntegrator( Integrator integrator ) { mIntegrator = integrator; }
+    void        setTaylorOrder( int order ) { mTaylorOrder = std::max( 2, std::min( order, TAYLOR_MAX_ORDER ) ); }
+    void        setTaylorTolerance( double tolerance ) { mTaylorTolerance = tolerance; }
+    void        setSampling( Sampling sampling, float spacing=DEFAULT_SAMPLE_SPACING, float tolerance=0.0f ) { mSampling = sampling; mSampleSpacing = spacing; mSampleTolerance = tolerance; }
+    Sampling    getSampling() const { return mSampling; }
     void        solve();
+    void        solve( ci::Vec3f *solutions, size_t numPositions );
+    void        solveEnsemble( const std::vector<ci::Vec3f> &initConditions, std::vector<ci::Vec3f> &solutions );
+    void        propagate( ci::Vec3f &u, size_t numSteps );
+    void        propagate( ci::Vec3d &u, size_t numSteps );
     ci::Vec3f   getCenterPos();
+    size_t      getRhsEvaluations() const { return mRhsEvaluations; }
     std::vector<ci::Vec3f> &   getSolutions() { return mSolutions; }
+    std::vector<ci::Vec3f> &   getSamples() { return mSamples; }
+    std::vector<uint32_t> &    getSampleSteps() { return mSampleSteps; }
+    size_t      getNumSamples( size_t numSteps ) const;
 
 private:
 
     void      initOnce() ;
-    void      nextStep( ci::Vec3f& u_t0, ci::Vec3f& u_t1 );
-    void      nextStepRK4( ci::Vec3f& u_t0, ci::Vec3f& u_t1 );
-    void      nextStepEuler( ci::Vec3f& u_t0, ci::Vec3f& u_t1 );
+    bool      isTaylor() const { return mIntegrator == INTEGRATOR_TAYLOR && mSystem == ATTRACTOR_LORENZ; }
+    void      integrate( ci::Vec3f u, ci::Vec3f *solutions, size_t numPositions ) const;
+    template<typename T> void advance( ci::Vec3<T> &u, size_t numSteps ) const;
+    template<class System> void integrateWith( const System &f, ci::Vec3f u, ci::Vec3f *solutions, size_t numPositions ) const;
+    template<class System, typename T> void advanceWith( const System &f, ci::Vec3<T> &u, size_t numSteps ) const;
+    size_t    solveTaylor( const ci::Vec3f& initCondition, ci::Vec3f *solutions, size_t numPositions );
+    void      resample();
     void      trackBounds( ci::Vec3f& u_t );
-    ci::Vec3f LorenzEquations( ci::Vec3f u );
 };
 
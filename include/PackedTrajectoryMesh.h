@@ -0,0 +1,88 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ The purpose of this class is to hold the trajectory spheres in
+ compact vertex formats, as an alternative to the float layout of the
+ main VBO mesh (12 bytes position + 12 normal + 4 RGBA8 color = 28 bytes):
+
+   static:  normal, 10:10:10:2 signed normalized (or 3 signed bytes)   4 bytes
+            color, RGBA8                                                4 bytes
+   dynamic: position, 3 floats                                        12 bytes
+            or 3 half floats (+ padding), relative to the chunk origin  8 bytes
+
+ That is 20 or 16 bytes per vertex. As with the float layout, update()
+ writes only the positions of the spheres that moved (one range), and
+ setSphereColors() only the colors that changed.
+
+ The spheres are grouped in chunks small enough to be drawn with one
+ 16-bit index list. Half float positions are stored relative to the
+ first sphere center of their chunk, which keeps the values small and
+ the precision high; each chunk is drawn translated to its origin.
+
+ Octahedral normals would need a shader to decode; the fixed function
+ lighting used by the app reads 10:10:10:2 natively.
+
+ */
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Vbo.h"
+#include "cinder/Color.h"
+#include "cinder/Vector.h"
+#include <vector>
+#include <ostream>
+#include <stdint.h>
+
+#include "SphereMeshModel.h"
+
+#define PACKED_CHUNK_SPHERES    32      // spheres per chunk; chunk vertices must fit in 16-bit indices
+
+
+class PackedTrajectoryMesh
+{
+public:
+
+    enum PositionFormat { POSITION_FLOAT, POSITION_HALF };
+
+    PackedTrajectoryMesh() : mNumSpheres(0), mFormat(POSITION_FLOAT), mNormalType(GL_BYTE), mVerticesPerSphere(0), mIndicesPerSphere(0), mDynamicStride(0), mColorOffset(0), mUploadBytes(0) {}
+
+    static PositionFormat getSupportedFormat( PositionFormat format );    // float where half floats are not supported
+
+    void    init( size_t numSpheres, const SphereMeshModel &sphereModel, PositionFormat format );
+    void    setSphereColors( const std::vector<ci::Colorf> &colors );   // one color per sphere
+    void    update( const std::vector<ci::Vec3f> &centers );
+    void    draw( size_t numSpheres );
+    bool    isInitialized() const { return mNumSpheres > 0; }
+    PositionFormat getFormat() const { return mFormat; }
+    size_t  getBytesPerVertex() const { return sizeof(uint32_t) + sizeof(ci::ColorA8u) + mDynamicStride; }
+    size_t  getDynamicBytes() const { return mNumSpheres * mVerticesPerSphere * mDynamicStride; }
+    size_t  getUploadBytes() const { return mUploadBytes; }        // written since resetUploadBytes()
+    void    resetUploadBytes() { mUploadBytes = 0; }
+    void    measurePrecision( const std::vector<ci::Vec3f> &centers, std::ostream &out ) const;
+
+private:
+
+    uint32_t packNormal( const ci::Vec3f &n ) const;
+    ci::Vec3f unpackNormal( uint32_t packed ) const;
+
+    size_t                  mNumSpheres;
+    PositionFormat          mFormat;
+    GLenum                  mNormalType;            // GL_INT_2_10_10_10_REV or GL_BYTE
+    uint32_t                mVerticesPerSphere;
+    uint32_t                mIndicesPerSphere;
+    size_t                  mDynamicStride;
+    size_t                  mColorOffset;           // of the colors in the static buffer
+    std::vector<ci::Vec3f>  mSpherePositions;       // one sphere around (0,0,0)
+    std::vector<ci::Vec3f>  mSphereNormals;
+    std::vector<ci::Colorf> mColors;
+    std::vector<ci::ColorA8u> mPackedColors;
+    std::vector<ci::Vec3f>  mChunkOrigins;
+    std::vector<ci::Vec3f>  mHeldCenters;           // the centers the dynamic buffer holds
+    std::vector<uint8_t>    mStaging;               // its dirty range, before it is uploaded
+    size_t                  mUploadBytes;
+    ci::gl::Vbo             mIndexVbo, mStaticVbo, mDynamicVbo;
+};
@@ -0,0 +1,83 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ The purpose of this class is to integrate one very long trajectory on
+ all the cores, with the Parareal time-parallel method (Lions, Maday,
+ Turinici 2001).
+
+ The time span is cut in N slices. A cheap coarse propagator G (Euler,
+ or RK4 at a large step) runs serially over the slice boundaries; the
+ expensive fine propagator F (RK4 at the small step) runs on all the
+ slices at once, each from its current start state. Iteration k then
+ corrects the boundaries serially:
+
+   U[n+1] = G(U_k[n]) + F(U_k-1[n]) - G(U_k-1[n])
+
+ After k iterations the first k slices are exact (as exact as the serial
+ fine run), so it always converges in at most N iterations; it pays off
+ when it converges in far fewer. It stops when no boundary moves by more
+ than the tolerance.
+
+ A chaotic trajectory only converges well within the predictability
+ horizon: beyond it, tiny boundary differences grow faster than the
+ corrections shrink them. run() therefore defaults to PARAREAL_DEFAULT_SPAN
+ and reaches a large number of steps by a small H. benchmark() runs the
+ serial fine integration as well and reports the speedup, the iterations
+ and the difference from the serial result.
+
+ Both propagators are LorenzSolver instances; their propagate() is safe
+ to call from several threads. They integrate the Lorenz system, or the
+ one given to setSystem(). The slice states are carried in double
+ precision: at the H of millions of steps per time unit, h*f(u) is near
+ the float epsilon of u and a float state would be mostly rounding.
+
+ */
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Vector.h"
+#include <vector>
+#include <ostream>
+
+#include "LorenzSolver.h"
+
+#define PARAREAL_DEFAULT_SPAN       10.0    // time units, within the predictability horizon
+#define PARAREAL_DEFAULT_COARSE_H   0.01f   // large-H RK4
+#define PARAREAL_DEFAULT_TOLERANCE  1.0e-3  // max boundary update to stop at, phase space units
+
+
+class PararealSolver
+{
+public:
+
+    struct Result {
+        size_t      mSlices;
+        size_t      mIterations;
+        bool        mIsConverged;
+        double      mWallTime;              // seconds
+        std::vector<double> mUpdates;       // max boundary update per iteration
+    };
+
+    PararealSolver( float s, float r, float b );
+
+    void    setFine( LorenzSolver::Integrator integrator, float h );
+    void    setCoarse( LorenzSolver::Integrator integrator, float h );
+    void    setSystem( AttractorSystem system, const float *params );
+    void    setSlices( size_t numSlices ) { mNumSlices = numSlices; }
+    void    setTolerance( double tolerance ) { mTolerance = tolerance; }
+    Result  run( const ci::Vec3f &initCondition, size_t numFineSteps, std::vector<ci::Vec3d> &boundaries );
+    void    benchmark( const ci::Vec3f &initCondition, size_t numFineSteps, std::ostream &out );
+
+private:
+
+    void    coarse( ci::Vec3d &u, size_t slice );
+
+    LorenzSolver            mFine, mCoarse;
+    float                   mFineH, mCoarseH;
+    size_t                  mNumSlices;
+    double                  mTolerance;
+    std::vector<size_t>     mSliceSteps;        // fine steps in each slice
+};
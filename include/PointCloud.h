@@ -0,0 +1,63 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ The purpose of this class is to draw trajectories of a million steps
+ and more, where a mesh per step is out of the question: one point per
+ step, drawn as a screen aligned point sprite.
+
+ The sprite texture is a shaded disc (an impostor of a sphere, lit from
+ a fixed direction in screen space), modulated by the step color; the
+ corners are cut by the alpha test, so depth testing still works. Point
+ sizes are attenuated with the distance, as for a sphere of the given
+ radius, up to the GL point size limit; close-ups want the sphere mesh.
+
+ The solver writes the positions straight into the mapped position
+ buffer, 12 bytes per step; the colors (blue to red by step, as in the
+ sphere view) are static and only rebuilt when the number of steps changes.
+
+ */
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Vbo.h"
+#include "cinder/gl/Texture.h"
+#include "cinder/Color.h"
+#include "cinder/Vector.h"
+#include <stdint.h>
+
+#include "LorenzSolver.h"
+
+#define POINT_CLOUD_SPRITE_SIZE     64      // texels of the impostor texture
+#define POINT_CLOUD_DEFAULT_RADIUS  0.3f    // phase space units
+
+
+class PointCloud
+{
+    size_t              mMaxPoints;
+    size_t              mNumPoints;         // solved by the last update()
+    size_t              mNumColors;         // steps the colors span
+    float               mRadius;
+    ci::gl::Vbo         mPositionVbo, mColorVbo;
+    ci::gl::Texture     mSprite;
+
+public:
+
+    PointCloud() : mMaxPoints(0), mNumPoints(0), mNumColors(0), mRadius(POINT_CLOUD_DEFAULT_RADIUS) {}
+
+    void    init( size_t maxPoints );
+    void    update( LorenzSolver &solver, size_t numPoints );
+    void    draw( size_t numPoints, float fovDegrees, int32_t viewportHeight );
+    void    setRadius( float radius ) { mRadius = radius; }
+    bool    isInitialized() const { return mMaxPoints > 0; }
+    size_t  getMaxPoints() const { return mMaxPoints; }
+    size_t  getNumPoints() const { return mNumPoints; }
+
+private:
+
+    void    buildColors( size_t numPoints );
+    void    buildSprite();
+};
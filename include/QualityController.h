@@ -0,0 +1,85 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ The purpose of this class is to hold the frame rate at a target by
+ trading quality for time, and to give the quality back when there is
+ time to spare.
+
+ The quality is a set of integer knobs, each within bounds the user
+ can change at any time; a higher value is always the higher quality.
+ Every knob is marked as costing solve time, render time or both.
+
+ Once per frame the controller gets the frame interval, the time the
+ frame was busy (update and draw) and the solve time, and keeps running
+ averages of them:
+
+   o frames too slow (interval above the target): one knob is lowered
+     by one step, preferably one costing what dominates the frame;
+   o frames mostly idle (busy well below the target, for a while): the
+     knob lowered last is raised again, one step.
+
+ After each change the averages are given a few frames to settle. The
+ lowered knobs are kept in a stack, so the quality comes back in the
+ reverse order it was given up.
+
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#define QUALITY_AVERAGING       0.1     // weight of the last frame in the running averages
+#define QUALITY_SETTLE_FRAMES   15      // frames after a change before the next one
+#define QUALITY_IDLE_FRAMES     60      // idle frames before raising the quality
+#define QUALITY_SLOW_MARGIN     1.1     // too slow: interval above the target by this factor
+#define QUALITY_IDLE_MARGIN     0.5     // idle: busy below this part of the target
+
+
+class QualityController
+{
+public:
+
+    enum Cost { COST_SOLVE = 1, COST_RENDER = 2, COST_BOTH = 3 };
+
+    QualityController();
+
+    size_t  addKnob( const std::string &name, Cost cost, int32_t minValue, int32_t maxValue, int32_t step=1 );  // starts at maxValue
+    void    setBounds( size_t knob, int32_t minValue, int32_t maxValue );
+    int32_t getValue( size_t knob ) const { return mKnobs[knob].mValue; }
+    int32_t* getValuePtr( size_t knob ) { return &mKnobs[knob].mValue; }
+    const std::string& getName( size_t knob ) const { return mKnobs[knob].mName; }
+    size_t  getNumKnobs() const { return mKnobs.size(); }
+
+    void    setTargetFps( double fps ) { mTargetInterval = 1.0 / fps; }
+    void    setEnabled( bool enabled );             // disabled: all knobs at their maximum
+    void    beginFrame( double now );               // at the start of the frame (update)
+    void    addSolveTime( double seconds );
+    bool    endFrame( double now );                 // after drawing; true when a knob changed
+    double  getAverageInterval() const { return mAvgInterval; }
+    double  getAverageBusy() const { return mAvgBusy; }
+    double  getAverageSolve() const { return mAvgSolve; }
+
+private:
+
+    struct Knob {
+        std::string mName;
+        Cost        mCost;
+        int32_t     mMin, mMax, mStep, mValue;
+    };
+
+    bool    lower();
+    bool    raise();
+
+    std::vector<Knob>   mKnobs;
+    std::vector<size_t> mLowered;           // knobs lowered, last on top
+    bool                mIsEnabled;
+    double              mTargetInterval;
+    double              mFrameStart, mLastFrameStart;
+    double              mFrameSolve;
+    double              mAvgInterval, mAvgBusy, mAvgSolve;
+    size_t              mFramesSinceChange, mIdleFrames;
+};
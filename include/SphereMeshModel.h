@@ -44,13 +44,18 @@ public:
     SphereMeshModel( const SphereMeshModel& o );
     SphereMeshModel& operator=(const SphereMeshModel &o);
 
-    void getStaticIndices( uint32_t startIndex, std::vector<uint32_t> &indices );
-    void getStaticNormals( std::vector<ci::Vec3f> &normals );
-    void updateVBO( ci::gl::VboMesh::VertexIter &vertexIter, const ci::Vec3f sphereCenterLocation, const ci::Colorf color=ci::Colorf::black());
+    uint32_t getNumVertices() const { return nVertices; }
+    uint32_t getNumIndices() const { return nIndices; }
+    void getStaticIndices( uint32_t startIndex, std::vector<uint32_t> &indices ) const;
+    void getStaticIndices( std::vector<uint16_t> &indices, uint32_t decimation=1 ) const;
+    void getLodDecimations( std::vector<uint32_t> &decimations ) const;
+    void getStaticNormals( std::vector<ci::Vec3f> &normals ) const;
+    void updatePositions( ci::Vec3f *pPositionsOut, const ci::Vec3f sphereCenterLocation ) const;
 
 private:
 
     void initUnitSphere();
+    template<typename T> void buildIndices( T startIndex, std::vector<T> &indices, uint32_t decimation ) const;
     void deepCopy( const SphereMeshModel& o );
 
 };
@@ -0,0 +1,84 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ The purpose of this class is to stream vertex data that changes every
+ frame without waiting for the GPU to finish the previous frames.
+
+ Mapping a buffer the GPU is still drawing from makes the driver wait
+ for the draw (or copy the buffer behind the scenes). Where the context
+ has buffer storage and sync objects, the buffer is a ring of
+ STREAMING_REGIONS regions, created immutable and mapped once for the
+ life of the buffer (persistent and coherent). Each map() moves on to the
+ next region and waits for the fence set after that region was last
+ drawn, which with three regions has long passed; map() costs nothing
+ more than that check.
+
+ On older contexts there is one region, orphaned by each map(): the
+ driver hands out fresh storage while the old one is still drawn from.
+ That region never holds the data of an earlier map(), so it has to be
+ written in full; a persistent region keeps what was written to it.
+
+ Usage per frame:
+   data = map();  ...write one region...  unmap();
+   bind();  ...gl*Pointer( getOffset() ), draw...  fence();  unbind();
+
+ */
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Vbo.h"
+#include <stdint.h>
+
+#include "GlExtensions.h"
+
+#define STREAMING_REGIONS           3
+#define STREAMING_WAIT_TIMEOUT      1000000000  // nanoseconds to wait for a region's fence
+
+
+class StreamingBuffer
+{
+public:
+
+    enum Mode {
+        MODE_NONE,          // not initialized
+        MODE_PERSISTENT,    // ring of regions, persistently mapped, guarded by fences
+        MODE_ORPHAN         // one region, orphaned and mapped per frame
+    };
+
+    StreamingBuffer();
+    ~StreamingBuffer();
+
+    void        init( size_t regionBytes, bool allowPersistent=true );
+    void        release();
+    uint8_t*    map();
+    void        unmap();
+    void        fence();
+    void        bind() const { mVbo.bind(); }
+    void        unbind() const { mVbo.unbind(); }
+
+    Mode        getMode() const { return mMode; }
+    bool        isPersistentAllowed() const { return mIsPersistentAllowed; }
+    size_t      getRegion() const { return mRegion; }
+    size_t      getOffset() const { return mRegion * mRegionBytes; }    // of the current region, for the gl*Pointer calls
+    double      getLastWaitTime() const { return mLastWaitTime; }       // seconds the last map() waited for the GPU
+
+private:
+
+    StreamingBuffer( const StreamingBuffer& );              // owns fences and a mapping; not copyable
+    StreamingBuffer& operator=( const StreamingBuffer& );
+
+    void        deleteFences();
+
+    Mode            mMode;
+    bool            mIsPersistentAllowed;
+    ci::gl::Vbo     mVbo;
+    size_t          mRegionBytes;
+    size_t          mRegion;                        // written by the last map()
+    uint8_t         *mMapped;                       // the whole ring, when persistent
+    glext::Sync     mFences[STREAMING_REGIONS];     // set after the last draw from each region
+    double          mLastWaitTime;
+};
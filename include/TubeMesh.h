@@ -0,0 +1,75 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ The purpose of this class is to render the trajectory as one tube swept
+ along it, as a lightweight alternative to a sphere per step: a ring of
+ a few vertices per trajectory point instead of a whole sphere.
+
+ The rings are oriented with parallel-transport frames (the rotation
+ minimizing "double reflection" method), so the tube does not twist
+ where the trajectory curves. The frame of a ring depends on all the
+ rings before it, so the rings are built in one pass from the start.
+
+ A CPU copy of the points, frames and vertices is kept: on update() only
+ the rings from the first changed point on are rebuilt and uploaded, and
+ nothing at all when the trajectory has not changed.
+
+ Vertex layout (interleaved): position, normal (floats), color RGBA8.
+ The indices are static; 16-bit when all the vertices fit.
+
+ */
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Vbo.h"
+#include "cinder/Color.h"
+#include "cinder/Vector.h"
+#include <vector>
+#include <stdint.h>
+
+#define TUBE_DEFAULT_SEGMENTS   8       // vertices per ring
+#define TUBE_DEFAULT_RADIUS     0.4f
+
+
+class TubeMesh
+{
+    struct Vertex {
+        ci::Vec3f   mPosition;
+        ci::Vec3f   mNormal;
+        ci::ColorA8u mColor;
+    };
+
+    size_t                  mMaxRings;
+    size_t                  mNumRings;          // built from the last update()
+    uint32_t                mSegments;
+    float                   mRadius;
+    GLenum                  mIndexType;
+    std::vector<ci::ColorA8u> mStepColors;      // color by step index
+    std::vector<ci::Vec3f>  mPoints;            // the last update(), to find what changed
+    std::vector<uint32_t>   mSteps;
+    std::vector<ci::Vec3f>  mTangents, mFrameNormals;
+    std::vector<Vertex>     mVertices;
+    std::vector<ci::Vec2f>  mRing;              // cos, sin per segment
+    size_t                  mLastUploadBytes;
+    ci::gl::Vbo             mIndexVbo, mVertexVbo;
+
+public:
+
+    TubeMesh() : mMaxRings(0), mNumRings(0), mSegments(0), mRadius(0.0f), mIndexType(GL_UNSIGNED_SHORT), mLastUploadBytes(0) {}
+
+    void    init( size_t maxRings, uint32_t segments=TUBE_DEFAULT_SEGMENTS, float radius=TUBE_DEFAULT_RADIUS );
+    void    setStepColors( const std::vector<ci::Colorf> &colors );
+    void    update( const std::vector<ci::Vec3f> &points, const std::vector<uint32_t> &steps );    // steps empty: point i is step i
+    void    draw( size_t numRings );
+    bool    isInitialized() const { return mMaxRings > 0; }
+    size_t  getLastUploadBytes() const { return mLastUploadBytes; }
+    size_t  getNumTriangles( size_t numRings ) const { return numRings > 1 ? 2 * (numRings-1) * mSegments : 0; }
+
+private:
+
+    void    buildRings( size_t first );
+};
@@ -0,0 +1,121 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ Conversions between float vertex data and the compact formats
+ OpenGL can read directly: half floats, signed normalized 10:10:10:2
+ and 8-bit normals. The unpack functions mirror what the GPU does and
+ are used to measure the precision loss.
+
+ */
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Vector.h"
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+
+// float -> IEEE 754 half, rounded to nearest
+inline uint16_t packHalf( float f )
+{
+    uint32_t x;
+    memcpy( &x, &f, sizeof(x) );
+    uint32_t sign = (x >> 16) & 0x8000;
+    int32_t  exp  = int32_t((x >> 23) & 0xFF) - 127 + 15;
+    uint32_t mant = x & 0x7FFFFF;
+    if( exp <= 0 ) {                        // half subnormal or zero
+        if( exp < -10 ) return uint16_t(sign);
+        mant |= 0x800000;
+        uint32_t shift = uint32_t(14 - exp);
+        uint32_t h = mant >> shift;
+        if( (mant >> (shift-1)) & 1 ) h++;
+        return uint16_t(sign | h);
+    }
+    if( exp >= 31 ) {                       // out of range: infinity
+        return uint16_t(sign | 0x7C00);
+    }
+    uint32_t h = sign | (uint32_t(exp) << 10) | (mant >> 13);
+    if( mant & 0x1000 ) h++;                // a carry into the exponent is still correct
+    return uint16_t(h);
+}
+
+
+inline float unpackHalf( uint16_t h )
+{
+    uint32_t sign = uint32_t(h & 0x8000) << 16;
+    uint32_t exp  = (h >> 10) & 0x1F;
+    uint32_t mant = h & 0x3FF;
+    if( exp == 0 ) {
+        float f = ldexpf( float(mant), -24 );
+        return sign ? -f : f;
+    }
+    uint32_t x = (exp == 31) ? (sign | 0x7F800000 | (mant << 13))
+                             : (sign | ((exp + 112) << 23) | (mant << 13));
+    float f;
+    memcpy( &f, &x, sizeof(f) );
+    return f;
+}
+
+
+// Unit normal -> GL_INT_2_10_10_10_REV: x in the low bits, w (unused) in the top 2
+inline uint32_t packSnorm10_10_10_2( const ci::Vec3f &n )
+{
+    uint32_t packed = 0;
+    for( int i=0; i<3; i++ ) {
+        float v = n[i] < -1.0f ? -1.0f : ( n[i] > 1.0f ? 1.0f : n[i] );
+        int32_t q = int32_t( floorf( v * 511.0f + 0.5f ) );
+        packed |= (uint32_t(q) & 0x3FF) << (10*i);
+    }
+    return packed;
+}
+
+
+inline ci::Vec3f unpackSnorm10_10_10_2( uint32_t packed )
+{
+    ci::Vec3f n;
+    for( int i=0; i<3; i++ ) {
+        int32_t q = int32_t( (packed >> (10*i)) & 0x3FF );
+        if( q & 0x200 ) q -= 0x400;         // sign extend
+        float v = float(q) / 511.0f;
+        n[i] = v < -1.0f ? -1.0f : v;
+    }
+    return n;
+}
+
+
+// Unit normal -> 3 signed bytes (+1 padding), for contexts without 10:10:10:2
+inline uint32_t packSnorm8( const ci::Vec3f &n )
+{
+    int8_t b[4] = { 0, 0, 0, 0 };
+    for( int i=0; i<3; i++ ) {
+        float v = n[i] < -1.0f ? -1.0f : ( n[i] > 1.0f ? 1.0f : n[i] );
+        b[i] = int8_t( floorf( v * 127.0f + 0.5f ) );
+    }
+    uint32_t packed;
+    memcpy( &packed, b, sizeof(packed) );
+    return packed;
+}
+
+
+inline ci::Vec3f unpackSnorm8( uint32_t packed )
+{
+    int8_t b[4];
+    memcpy( b, &packed, sizeof(packed) );
+    ci::Vec3f n;
+    for( int i=0; i<3; i++ ) {
+        float v = float(b[i]) / 127.0f;
+        n[i] = v < -1.0f ? -1.0f : v;
+    }
+    return n;
+}
+
+
+inline uint8_t packUnorm8( float v )
+{
+    v = v < 0.0f ? 0.0f : ( v > 1.0f ? 1.0f : v );
+    return uint8_t( floorf( v * 255.0f + 0.5f ) );
+}
@@ -0,0 +1,85 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ Parameter metadata of the attractor systems; see AttractorSystems.h.
+*/
+
+#include "cinder/Cinder.h"
+#include "cinder/Vector.h"
+#include <assert.h>
+
+#include "AttractorSystems.h"
+#include "LorenzSolver.h"
+
+using namespace ci;
+
+
+// name, default, min, max, step
+
+const char *LorenzSystem::sName = "Lorenz";
+const AttractorParam LorenzSystem::sParams[LorenzSystem::NUM_PARAMS] = {
+    { "S", DEFAULT_PAR_S, 1.0f, 50.0f, 0.1f },
+    { "R", DEFAULT_PAR_R, 1.0f, 50.0f, 0.1f },
+    { "B", DEFAULT_PAR_B, 1.0f, 50.0f, 0.1f } };
+const Vec3f LorenzSystem::sInitialCondition( 0.1f, 0.1f, 0.1f );
+const float LorenzSystem::sH = DEFAULT_H;
+
+const char *RosslerSystem::sName = "Rossler";
+const AttractorParam RosslerSystem::sParams[RosslerSystem::NUM_PARAMS] = {
+    { "a", 0.2f, 0.0f, 1.0f, 0.01f },
+    { "b", 0.2f, 0.0f, 2.0f, 0.01f },
+    { "c", 5.7f, 1.0f, 20.0f, 0.1f } };
+const Vec3f RosslerSystem::sInitialCondition( 1.0f, 1.0f, 0.0f );
+const float RosslerSystem::sH = 0.03f;
+
+const char *ChenSystem::sName = "Chen";
+const AttractorParam ChenSystem::sParams[ChenSystem::NUM_PARAMS] = {
+    { "a", 35.0f, 1.0f, 50.0f, 0.1f },
+    { "b", 3.0f, 0.1f, 10.0f, 0.1f },
+    { "c", 28.0f, 1.0f, 50.0f, 0.1f } };
+const Vec3f ChenSystem::sInitialCondition( -10.0f, 0.0f, 37.0f );
+const float ChenSystem::sH = 0.005f;
+
+const char *ThomasSystem::sName = "Thomas";
+const AttractorParam ThomasSystem::sParams[ThomasSystem::NUM_PARAMS] = {
+    { "b", 0.208186f, 0.01f, 1.0f, 0.001f } };
+const Vec3f ThomasSystem::sInitialCondition( 0.1f, 0.0f, 0.0f );
+const float ThomasSystem::sH = 0.05f;
+
+const char *HalvorsenSystem::sName = "Halvorsen";
+const AttractorParam HalvorsenSystem::sParams[HalvorsenSystem::NUM_PARAMS] = {
+    { "a", 1.89f, 0.5f, 3.0f, 0.01f } };
+const Vec3f HalvorsenSystem::sInitialCondition( -1.48f, -1.51f, 2.04f );
+const float HalvorsenSystem::sH = 0.01f;
+
+
+namespace {
+
+    template<class System> AttractorInfo infoOf()
+    {
+        static_assert( System::NUM_PARAMS <= ATTRACTOR_MAX_PARAMS, "ATTRACTOR_MAX_PARAMS too small" );
+        for( size_t i=0; i<System::NUM_PARAMS; i++ ) {
+            assert( System::sParams[i].mName != NULL );     // every parameter described
+        }
+        AttractorInfo info = { System::sName, System::NUM_PARAMS, System::sParams, System::sInitialCondition, System::sH };
+        return info;
+    }
+
+    // in the order of AttractorSystem; the traits above are initialized first
+    const AttractorInfo sAttractors[ATTRACTOR_COUNT] = {
+        infoOf<LorenzSystem>(),
+        infoOf<RosslerSystem>(),
+        infoOf<ChenSystem>(),
+        infoOf<ThomasSystem>(),
+        infoOf<HalvorsenSystem>()
+    };
+
+}
+
+
+const AttractorInfo& getAttractorInfo( AttractorSystem system )
+{
+    return sAttractors[ system < ATTRACTOR_COUNT ? system : ATTRACTOR_LORENZ ];
+}
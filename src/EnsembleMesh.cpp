@@ -0,0 +1,159 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ Ensemble of trajectories drawn with one multi-draw call; see EnsembleMesh.h.
+
+ NOTE: the buffers are sized once for the maximal ensemble, so changing
+ ----  the number of trajectories only changes what gets drawn.
+*/
+
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Vbo.h"
+#include "cinder/Color.h"
+#include "cinder/Vector.h"
+#include <vector>
+#include <stddef.h>
+#include <ppl.h>
+
+#include "EnsembleMesh.h"
+#include "GlExtensions.h"
+
+using namespace ci;
+using namespace std;
+
+
+// Build the shared index set and the static vertex data, allocate the positions
+//
+void EnsembleMesh::init( size_t maxTrajectories, size_t stepsPerTrajectory, const SphereMeshModel &sphereModel )
+{
+    mSphereModel = sphereModel;
+    mMaxTrajectories = maxTrajectories;
+    mStepsPerTrajectory = stepsPerTrajectory;
+    mNumTrajectories = 0;
+    uint32_t nVerticesPerSphere = mSphereModel.getNumVertices();
+    mVerticesPerTrajectory = uint32_t(mStepsPerTrajectory) * nVerticesPerSphere;
+    size_t nVertices = mMaxTrajectories * mVerticesPerTrajectory;
+
+    // One trajectory's worth of indices, shared by all of them
+    vector<uint32_t> indices;
+    indices.reserve( mStepsPerTrajectory * mSphereModel.getNumIndices() );
+    for( size_t i=0; i<mStepsPerTrajectory; i++ ) {
+        mSphereModel.getStaticIndices( uint32_t(i) * nVerticesPerSphere, indices );
+    }
+    mIndexVbo = gl::Vbo( GL_ELEMENT_ARRAY_BUFFER );
+    mIndexVbo.bufferData( indices.size() * sizeof(uint32_t), &indices[0], GL_STATIC_DRAW );
+    mIndexVbo.unbind();
+
+    // Normals repeat per sphere; the color tells the trajectory apart (hue)
+    // and, as in the single trajectory view, gets brighter with the step.
+    vector<Vec3f> sphereNormals;
+    mSphereModel.getStaticNormals( sphereNormals );
+    vector<StaticVertex> staticVertices( nVertices );
+    StaticVertex *sv = &staticVertices[0];
+    for( size_t k=0; k<mMaxTrajectories; k++ ) {
+        float hue = float(k) / float(mMaxTrajectories);
+        for( size_t i=0; i<mStepsPerTrajectory; i++ ) {
+            float brightness = 0.4f + 0.6f * float(i) / float(mStepsPerTrajectory);
+            Colorf c( CM_HSV, hue, 0.8f, brightness );
+            ColorA8u color( uint8_t(c.r*255.0f), uint8_t(c.g*255.0f), uint8_t(c.b*255.0f), 255 );
+            for( uint32_t v=0; v<nVerticesPerSphere; v++ ) {
+                sv->mNormal = sphereNormals[v];
+                sv->mColor = color;
+                ++sv;
+            }
+        }
+    }
+    mStaticVbo = gl::Vbo( GL_ARRAY_BUFFER );
+    mStaticVbo.bufferData( nVertices * sizeof(StaticVertex), &staticVertices[0], GL_STATIC_DRAW );
+    mDynamicVbo = gl::Vbo( GL_ARRAY_BUFFER );
+    mDynamicVbo.bufferData( nVertices * sizeof(Vec3f), NULL, GL_STREAM_DRAW );
+    mDynamicVbo.unbind();
+
+    mCounts.assign( mMaxTrajectories, 0 );
+    mOffsets.assign( mMaxTrajectories, (const GLvoid*) 0 );
+    mBaseVertices.resize( mMaxTrajectories );
+    for( size_t k=0; k<mMaxTrajectories; k++ ) {
+        mBaseVertices[k] = GLint( k * mVerticesPerTrajectory );
+    }
+}
+
+
+// Write the sphere positions of the first numTrajectories trajectories;
+// centers is trajectory-major, see LorenzSolver::solveEnsemble().
+//
+void EnsembleMesh::updatePositions( const vector<Vec3f> &centers, size_t numTrajectories )
+{
+    mNumTrajectories = min( numTrajectories, mMaxTrajectories );
+    if( mNumTrajectories == 0 ) return;
+    uint32_t nVerticesPerSphere = mSphereModel.getNumVertices();
+
+    // orphan the old storage, so we don't wait for the GPU to finish with it
+    mDynamicVbo.bufferData( mMaxTrajectories * mVerticesPerTrajectory * sizeof(Vec3f), NULL, GL_STREAM_DRAW );
+    Vec3f *positions = reinterpret_cast<Vec3f*>( mDynamicVbo.map( GL_WRITE_ONLY ) );
+    if( positions != NULL ) {
+        concurrency::parallel_for( size_t(0), mNumTrajectories, [&]( size_t k ) {
+            Vec3f *out = positions + k * mVerticesPerTrajectory;
+            const Vec3f *c = &centers[k * mStepsPerTrajectory];
+            for( size_t i=0; i<mStepsPerTrajectory; i++ ) {
+                mSphereModel.updatePositions( out, *c++ );
+                out += nVerticesPerSphere;
+            }
+        });
+        mDynamicVbo.unmap();
+    }
+    mDynamicVbo.unbind();
+}
+
+
+void EnsembleMesh::setDrawRange( size_t trajectory, size_t firstStep, size_t numSteps )
+{
+    if( trajectory >= mMaxTrajectories ) return;
+    firstStep = min( firstStep, mStepsPerTrajectory );
+    numSteps = min( numSteps, mStepsPerTrajectory - firstStep );
+    size_t indicesPerSphere = mSphereModel.getNumIndices();
+    mCounts[trajectory] = GLsizei( numSteps * indicesPerSphere );
+    mOffsets[trajectory] = (const GLvoid*)( firstStep * indicesPerSphere * sizeof(uint32_t) );
+}
+
+
+// Bind the vertex arrays, starting at the given vertex
+//
+void EnsembleMesh::setPointers( size_t baseVertex )
+{
+    mStaticVbo.bind();
+    glNormalPointer( GL_FLOAT, sizeof(StaticVertex), (const GLvoid*)( baseVertex*sizeof(StaticVertex) + offsetof(StaticVertex, mNormal) ) );
+    glColorPointer( 4, GL_UNSIGNED_BYTE, sizeof(StaticVertex), (const GLvoid*)( baseVertex*sizeof(StaticVertex) + offsetof(StaticVertex, mColor) ) );
+    mDynamicVbo.bind();
+    glVertexPointer( 3, GL_FLOAT, 0, (const GLvoid*)( baseVertex*sizeof(Vec3f) ) );
+}
+
+
+// All trajectories in one call; without base vertex support
+// each trajectory is drawn with the arrays re-pointed at its block.
+//
+void EnsembleMesh::draw()
+{
+    if( mNumTrajectories == 0 ) return;
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_NORMAL_ARRAY );
+    glEnableClientState( GL_COLOR_ARRAY );
+    mIndexVbo.bind();
+    if( glext::hasDrawElementsBaseVertex() ) {
+        setPointers( 0 );
+        glext::multiDrawElementsBaseVertex( GL_TRIANGLES, &mCounts[0], GL_UNSIGNED_INT, &mOffsets[0], GLsizei(mNumTrajectories), &mBaseVertices[0] );
+    } else {
+        for( size_t k=0; k<mNumTrajectories; k++ ) {
+            if( mCounts[k] == 0 ) continue;
+            setPointers( mBaseVertices[k] );
+            glDrawElements( GL_TRIANGLES, mCounts[k], GL_UNSIGNED_INT, mOffsets[k] );
+        }
+    }
+    mIndexVbo.unbind();
+    mDynamicVbo.unbind();
+    glDisableClientState( GL_VERTEX_ARRAY );
+    glDisableClientState( GL_NORMAL_ARRAY );
+    glDisableClientState( GL_COLOR_ARRAY );
+}
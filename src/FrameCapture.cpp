@@ -0,0 +1,215 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ Asynchronous frame capture; see FrameCapture.h.
+
+ The render thread only issues glReadPixels into a PBO and, a few
+ frames later, copies the mapped pixels into a Surface. Everything
+ slow - flipping, PNG compression, disk I/O - runs on the encoder thread.
+*/
+
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Vbo.h"
+#include "cinder/Surface.h"
+#include "cinder/ImageIo.h"
+#include "cinder/ip/Flip.h"
+#include <cinder/app/App.h>
+#include <sstream>
+#include <iomanip>
+#include <string.h>
+
+#include "FrameCapture.h"
+
+using namespace ci;
+using namespace std;
+
+
+FrameCapture::FrameCapture() :
+    mWidth(0), mHeight(0), mFormat(FORMAT_PNG), mIsCapturing(false),
+    mFramesCaptured(0), mBackpressureWaits(0), mStopEncoder(false), mFramesWritten(0)
+{
+}
+
+
+FrameCapture::~FrameCapture()
+{
+    stop();
+}
+
+
+// Allocate the PBO ring and launch the encoder thread
+//
+void FrameCapture::start( const fs::path &directory, int32_t width, int32_t height, Format format )
+{
+    if( mIsCapturing ) {
+        stop();
+    }
+    mDirectory = directory;
+    mWidth = width;
+    mHeight = height;
+    mFormat = format;
+    mFramesCaptured = 0;
+    mFramesWritten = 0;
+    mBackpressureWaits = 0;
+    mStopEncoder = false;
+    fs::create_directories( mDirectory );
+
+    size_t frameBytes = size_t(mWidth) * size_t(mHeight) * 4;
+    mPbos.clear();
+    mPboPending.assign( CAPTURE_NUM_PBOS, false );
+    mPboFrame.assign( CAPTURE_NUM_PBOS, 0 );
+    for( size_t i=0; i<CAPTURE_NUM_PBOS; i++ ) {
+        mPbos.push_back( gl::Vbo( GL_PIXEL_PACK_BUFFER ) );
+        mPbos[i].bufferData( frameBytes, NULL, GL_STREAM_READ );
+        mPbos[i].unbind();
+    }
+
+    if( mFormat == FORMAT_RAW ) {
+        // One headerless RGBA stream, top row first, e.g. for
+        // ffmpeg -f rawvideo -pix_fmt rgba -s WxH -i frames.rgba ...
+        mRawStream.open( (mDirectory / "frames.rgba").string().c_str(), ios::out | ios::binary | ios::trunc );
+        ofstream info( (mDirectory / "frames.txt").string().c_str() );
+        info << "width " << mWidth << "\nheight " << mHeight << "\nformat rgba8\n";
+    }
+
+    mEncoder = thread( [this](){ encoderLoop(); } );
+    mIsCapturing = true;
+}
+
+
+// Issue the asynchronous read-back of the current frame. The slot being
+// reused holds the frame captured CAPTURE_NUM_PBOS frames ago, which the
+// GPU has long finished; it is drained first, so frames stay in order.
+//
+void FrameCapture::captureFrame()
+{
+    if( ! mIsCapturing ) return;
+    size_t slot = mFramesCaptured % CAPTURE_NUM_PBOS;
+    if( mPboPending[slot] ) {
+        readBack( slot );
+    }
+    mPbos[slot].bind();
+    glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+    glReadPixels( 0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, 0 );
+    mPbos[slot].unbind();
+    mPboPending[slot] = true;
+    mPboFrame[slot] = mFramesCaptured;
+    mFramesCaptured++;
+}
+
+
+// Read back whatever is still in the ring, let the encoder finish the queue
+//
+void FrameCapture::stop()
+{
+    if( ! mIsCapturing ) return;
+    for( size_t i=0; i<CAPTURE_NUM_PBOS; i++ ) {
+        size_t slot = (mFramesCaptured + i) % CAPTURE_NUM_PBOS;    // oldest first
+        if( mPboPending[slot] ) {
+            readBack( slot );
+        }
+    }
+    {
+        lock_guard<mutex> lock( mMutex );
+        mStopEncoder = true;
+    }
+    mQueueNotEmpty.notify_all();
+    mEncoder.join();
+    if( mRawStream.is_open() ) {
+        mRawStream.close();
+    }
+    mPbos.clear();
+    mIsCapturing = false;
+    app::console() << "Capture: " << mFramesWritten << " frames written to " << mDirectory
+                   << ", render loop waited for the encoder " << mBackpressureWaits << " times" << endl;
+}
+
+
+size_t FrameCapture::getFramesWritten()
+{
+    lock_guard<mutex> lock( mMutex );
+    return mFramesWritten;
+}
+
+
+// Map a PBO and copy its pixels out, so the buffer can be reused right away
+//
+void FrameCapture::readBack( size_t slot )
+{
+    Frame frame;
+    frame.mSurface = Surface8u( mWidth, mHeight, true, SurfaceChannelOrder::RGBA );
+    frame.mNumber = mPboFrame[slot];
+
+    mPbos[slot].bind();
+    const uint8_t *src = static_cast<const uint8_t*>( glMapBuffer( GL_PIXEL_PACK_BUFFER, GL_READ_ONLY ) );
+    if( src != NULL ) {
+        size_t srcRowBytes = size_t(mWidth) * 4;
+        for( int32_t row=0; row<mHeight; row++ ) {
+            memcpy( frame.mSurface.getData( Vec2i(0, row) ), src + row*srcRowBytes, srcRowBytes );
+        }
+        glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+    }
+    mPbos[slot].unbind();
+    mPboPending[slot] = false;
+
+    enqueue( frame );
+}
+
+
+// Hand a frame to the encoder; wait while the queue is full rather than drop it
+//
+void FrameCapture::enqueue( const Frame &frame )
+{
+    unique_lock<mutex> lock( mMutex );
+    if( mQueue.size() >= CAPTURE_QUEUE_SIZE ) {
+        mBackpressureWaits++;
+        mQueueNotFull.wait( lock, [this](){ return mQueue.size() < CAPTURE_QUEUE_SIZE; } );
+    }
+    mQueue.push_back( frame );
+    lock.unlock();
+    mQueueNotEmpty.notify_one();
+}
+
+
+void FrameCapture::encoderLoop()
+{
+    for(;;) {
+        Frame frame;
+        {
+            unique_lock<mutex> lock( mMutex );
+            mQueueNotEmpty.wait( lock, [this](){ return mStopEncoder || ! mQueue.empty(); } );
+            if( mQueue.empty() ) {
+                return;     // stop requested and nothing left to write
+            }
+            frame = mQueue.front();
+            mQueue.pop_front();
+        }
+        mQueueNotFull.notify_one();
+        writeFrame( frame );
+        {
+            lock_guard<mutex> lock( mMutex );
+            mFramesWritten++;
+        }
+    }
+}
+
+
+// Runs on the encoder thread. OpenGL rows are bottom-up, images are top-down.
+//
+void FrameCapture::writeFrame( Frame &frame )
+{
+    ip::flipVertical( &frame.mSurface );
+    if( mFormat == FORMAT_RAW ) {
+        size_t rowBytes = size_t(mWidth) * 4;
+        for( int32_t row=0; row<mHeight; row++ ) {
+            mRawStream.write( reinterpret_cast<const char*>( frame.mSurface.getData( Vec2i(0, row) ) ), rowBytes );
+        }
+    } else {
+        stringstream name;
+        name << "frame_" << setw(6) << setfill('0') << frame.mNumber << ".png";
+        writeImage( mDirectory / name.str(), frame.mSurface );
+    }
+}
@@ -0,0 +1,169 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ Loader for the OpenGL entry points declared in GlExtensions.h.
+*/
+
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include <string>
+#include <stdio.h>
+
+#include "GlExtensions.h"
+
+using namespace std;
+
+
+#if defined( CINDER_MSW )
+    #define GLEXT_APIENTRY  APIENTRY
+#else
+    #define GLEXT_APIENTRY
+#endif
+
+typedef void (GLEXT_APIENTRY *PfnDrawElementsBaseVertex)( GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLint baseVertex );
+typedef void (GLEXT_APIENTRY *PfnMultiDrawElementsBaseVertex)( GLenum mode, const GLsizei *counts, GLenum type, const GLvoid **indices, GLsizei drawCount, const GLint *baseVertices );
+typedef void (GLEXT_APIENTRY *PfnBufferStorage)( GLenum target, ptrdiff_t size, const GLvoid *data, GLbitfield flags );
+typedef void* (GLEXT_APIENTRY *PfnMapBufferRange)( GLenum target, ptrdiff_t offset, ptrdiff_t length, GLbitfield access );
+typedef glext::Sync (GLEXT_APIENTRY *PfnFenceSync)( GLenum condition, GLbitfield flags );
+typedef GLenum (GLEXT_APIENTRY *PfnClientWaitSync)( glext::Sync sync, GLbitfield flags, uint64_t timeout );
+typedef void (GLEXT_APIENTRY *PfnDeleteSync)( glext::Sync sync );
+
+
+namespace {
+
+    PfnDrawElementsBaseVertex       pDrawElementsBaseVertex = NULL;
+    PfnMultiDrawElementsBaseVertex  pMultiDrawElementsBaseVertex = NULL;
+    PfnBufferStorage                pBufferStorage = NULL;
+    PfnMapBufferRange               pMapBufferRange = NULL;
+    PfnFenceSync                    pFenceSync = NULL;
+    PfnClientWaitSync               pClientWaitSync = NULL;
+    PfnDeleteSync                   pDeleteSync = NULL;
+    int                             sVersionMajor = 0;
+    int                             sVersionMinor = 0;
+    string                          sExtensions;
+    bool                            sHasHalfFloatVertex = false;
+    bool                            sHasVertexType2_10_10_10_Rev = false;
+
+
+    void* getProcAddress( const char *name )
+    {
+#if defined( CINDER_MSW )
+        return (void*) wglGetProcAddress( name );
+#else
+        return NULL;    // legacy (2.1) contexts on the other platforms have none of these
+#endif
+    }
+
+
+    // A feature is there either as part of the core version or as an extension
+    bool isSupported( int major, int minor, const char *extension )
+    {
+        if( sVersionMajor > major || (sVersionMajor == major && sVersionMinor >= minor) ) {
+            return true;
+        }
+        // whole names only: one extension name may end with another
+        return sExtensions.find( " " + string(extension) + " " ) != string::npos;
+    }
+
+}
+
+
+void glext::init()
+{
+    const char *version = (const char*) glGetString( GL_VERSION );
+    if( version != NULL ) {
+        sscanf( version, "%d.%d", &sVersionMajor, &sVersionMinor );
+    }
+    const char *extensions = (const char*) glGetString( GL_EXTENSIONS );
+    sExtensions = extensions ? " " + string(extensions) + " " : string();
+
+    if( isSupported( 3, 2, "GL_ARB_draw_elements_base_vertex" ) ) {
+        pDrawElementsBaseVertex = (PfnDrawElementsBaseVertex) getProcAddress( "glDrawElementsBaseVertex" );
+        pMultiDrawElementsBaseVertex = (PfnMultiDrawElementsBaseVertex) getProcAddress( "glMultiDrawElementsBaseVertex" );
+    }
+    if( isSupported( 4, 4, "GL_ARB_buffer_storage" ) && isSupported( 3, 0, "GL_ARB_map_buffer_range" ) ) {
+        pBufferStorage = (PfnBufferStorage) getProcAddress( "glBufferStorage" );
+        pMapBufferRange = (PfnMapBufferRange) getProcAddress( "glMapBufferRange" );
+    }
+    if( isSupported( 3, 2, "GL_ARB_sync" ) ) {
+        pFenceSync = (PfnFenceSync) getProcAddress( "glFenceSync" );
+        pClientWaitSync = (PfnClientWaitSync) getProcAddress( "glClientWaitSync" );
+        pDeleteSync = (PfnDeleteSync) getProcAddress( "glDeleteSync" );
+    }
+    sHasHalfFloatVertex = isSupported( 3, 0, "GL_ARB_half_float_vertex" );
+    sHasVertexType2_10_10_10_Rev = isSupported( 3, 3, "GL_ARB_vertex_type_2_10_10_10_rev" );
+}
+
+
+bool glext::hasDrawElementsBaseVertex()
+{
+    return pDrawElementsBaseVertex != NULL && pMultiDrawElementsBaseVertex != NULL;
+}
+
+
+void glext::drawElementsBaseVertex( GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLint baseVertex )
+{
+    pDrawElementsBaseVertex( mode, count, type, indices, baseVertex );
+}
+
+
+void glext::multiDrawElementsBaseVertex( GLenum mode, const GLsizei *counts, GLenum type, const GLvoid **indices, GLsizei drawCount, const GLint *baseVertices )
+{
+    pMultiDrawElementsBaseVertex( mode, counts, type, indices, drawCount, baseVertices );
+}
+
+
+bool glext::hasHalfFloatVertex()
+{
+    return sHasHalfFloatVertex;
+}
+
+
+bool glext::hasVertexType2_10_10_10_Rev()
+{
+    return sHasVertexType2_10_10_10_Rev;
+}
+
+
+bool glext::hasBufferStorage()
+{
+    return pBufferStorage != NULL && pMapBufferRange != NULL;
+}
+
+
+void glext::bufferStorage( GLenum target, size_t size, const GLvoid *data, GLbitfield flags )
+{
+    pBufferStorage( target, ptrdiff_t(size), data, flags );
+}
+
+
+void* glext::mapBufferRange( GLenum target, size_t offset, size_t length, GLbitfield access )
+{
+    return pMapBufferRange( target, ptrdiff_t(offset), ptrdiff_t(length), access );
+}
+
+
+bool glext::hasSync()
+{
+    return pFenceSync != NULL && pClientWaitSync != NULL && pDeleteSync != NULL;
+}
+
+
+glext::Sync glext::fenceSync( GLenum condition, GLbitfield flags )
+{
+    return pFenceSync( condition, flags );
+}
+
+
+GLenum glext::clientWaitSync( Sync sync, GLbitfield flags, uint64_t timeout )
+{
+    return pClientWaitSync( sync, flags, timeout );
+}
+
+
+void glext::deleteSync( Sync sync )
+{
+    pDeleteSync( sync );
+}
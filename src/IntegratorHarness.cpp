@@ -0,0 +1,307 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ Integrator accuracy-versus-cost harness; see IntegratorHarness.h.
+*/
+
+#include "cinder/Cinder.h"
+#include "cinder/Vector.h"
+#include "cinder/Timer.h"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <math.h>
+
+#include "IntegratorHarness.h"
+#include "LorenzSolver.h"
+
+using namespace ci;
+using namespace std;
+
+// The H grid, given as steps per sample interval: H = HARNESS_SAMPLE_INTERVAL / n.
+// Every n from 1 to 10 (H = 0.05 ... 0.005, where the integrators part ways),
+// then roughly geometric, a factor 1.25 ... 2 apart, down to H = 1e-4
+static const size_t sStepsPerSample[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 13, 16, 20, 25, 32, 40, 50, 71, 100, 141, 200, 283, 500 };
+// ...and the tolerance grid of the integrators with automatic step size
+static const double sTolerances[] = { 1e-3, 1e-4, 1e-6, 1e-8, 1e-10, 1e-12, 1e-14 };
+
+
+IntegratorHarness::IntegratorHarness( float s, float r, float b, const Vec3f &initCondition ) :
+    mS(s), mR(r), mB(b), mInitCondition(initCondition)
+{
+}
+
+
+void IntegratorHarness::addIntegrator( const string &name, const function<void (LorenzSolver&)> &configure )
+{
+    Integrator integrator;
+    integrator.mName = name;
+    integrator.mConfigure = configure;
+    mIntegrators.push_back( integrator );
+}
+
+
+void IntegratorHarness::addAdaptiveIntegrator( const string &name, const function<void (LorenzSolver&, double)> &configure )
+{
+    Integrator integrator;
+    integrator.mName = name;
+    integrator.mConfigureAdaptive = configure;
+    mIntegrators.push_back( integrator );
+}
+
+
+void IntegratorHarness::addDefaultIntegrators()
+{
+    addIntegrator( "Euler", []( LorenzSolver &solver ){ solver.useRK4( false ); } );
+    addIntegrator( "RK4", []( LorenzSolver &solver ){ solver.useRK4( true ); } );
+    addAdaptiveIntegrator( "Taylor10", []( LorenzSolver &solver, double tolerance ){
+        solver.setIntegrator( LorenzSolver::INTEGRATOR_TAYLOR ); solver.setTaylorOrder( 10 ); solver.setTaylorTolerance( tolerance ); } );
+    addAdaptiveIntegrator( "Taylor20", []( LorenzSolver &solver, double tolerance ){
+        solver.setIntegrator( LorenzSolver::INTEGRATOR_TAYLOR ); solver.setTaylorOrder( 20 ); solver.setTaylorTolerance( tolerance ); } );
+    addAdaptiveIntegrator( "Taylor30", []( LorenzSolver &solver, double tolerance ){
+        solver.setIntegrator( LorenzSolver::INTEGRATOR_TAYLOR ); solver.setTaylorOrder( 30 ); solver.setTaylorTolerance( tolerance ); } );
+}
+
+
+// Reference first, then every integrator at every H
+//
+void IntegratorHarness::run( ostream &log )
+{
+    computeReference( HARNESS_REFERENCE_H, mReference );
+    vector<Vec3d> check;
+    computeReference( HARNESS_REFERENCE_H / 2.0, check );
+    double refError = 0.0;
+    size_t errorSamples = size_t( HARNESS_ERROR_SPAN / HARNESS_SAMPLE_INTERVAL + 0.5 );
+    for( size_t i=0; i<=errorSamples; i++ ) {
+        refError = max( refError, mReference[i].distance( check[i] ) );
+    }
+    log << "Reference: double precision RK4, H=" << HARNESS_REFERENCE_H
+        << ", differs from H/2 by at most " << refError << " over t <= " << HARNESS_ERROR_SPAN << endl;
+
+    mResults.clear();
+    for( size_t k=0; k<mIntegrators.size(); k++ ) {
+        if( mIntegrators[k].mConfigureAdaptive ) {
+            for( size_t j=0; j<sizeof(sTolerances)/sizeof(sTolerances[0]); j++ ) {
+                mResults.push_back( measure( mIntegrators[k], 1, sTolerances[j] ) );
+            }
+        } else {
+            for( size_t j=0; j<sizeof(sStepsPerSample)/sizeof(sStepsPerSample[0]); j++ ) {
+                mResults.push_back( measure( mIntegrators[k], sStepsPerSample[j], 0.0 ) );
+            }
+        }
+    }
+    markPareto();
+}
+
+
+// Double precision RK4, sampled at every HARNESS_SAMPLE_INTERVAL
+//
+void IntegratorHarness::computeReference( double h, vector<Vec3d> &samples ) const
+{
+    struct Lorenz {
+        double s, r, b;
+        Vec3d operator()( const Vec3d &u ) const {
+            return Vec3d( s * (u.y - u.x), -u.x * u.z + r * u.x - u.y, u.x * u.y - b * u.z );
+        }
+    };
+    Lorenz f = { mS, mR, mB };
+    size_t stepsPerSample = size_t( HARNESS_SAMPLE_INTERVAL / h + 0.5 );
+    size_t numSamples = size_t( HARNESS_TRACK_SPAN / HARNESS_SAMPLE_INTERVAL + 0.5 ) + 1;
+    Vec3d u( mInitCondition.x, mInitCondition.y, mInitCondition.z );
+    samples.clear();
+    samples.push_back( u );
+    for( size_t i=1; i<numSamples; i++ ) {
+        for( size_t j=0; j<stepsPerSample; j++ ) {
+            Vec3d k1 = f( u );
+            Vec3d k2 = f( u + k1 * (0.5*h) );
+            Vec3d k3 = f( u + k2 * (0.5*h) );
+            Vec3d k4 = f( u + k3 * h );
+            u += ( k1 + k2 * 2.0 + k3 * 2.0 + k4 ) * (h/6.0);
+        }
+        samples.push_back( u );
+    }
+}
+
+
+// Run one integrator at H = HARNESS_SAMPLE_INTERVAL / stepsPerSample (or
+// at the given tolerance), through LorenzSolver itself, so the code under 
+// test is the app's.
+//
+IntegratorHarness::Result IntegratorHarness::measure( const Integrator &integrator, size_t stepsPerSample, double tolerance ) const
+{
+    double h = HARNESS_SAMPLE_INTERVAL / stepsPerSample;
+    size_t numSamples = mReference.size();
+    size_t errorSamples = size_t( HARNESS_ERROR_SPAN / HARNESS_SAMPLE_INTERVAL + 0.5 );
+
+    LorenzSolver solver( numSamples, mInitCondition, float(h), mS, mR, mB );
+    solver.setIntegrationStep( float(h), stepsPerSample );
+    if( integrator.mConfigureAdaptive ) {
+        integrator.mConfigureAdaptive( solver, tolerance );
+    } else {
+        integrator.mConfigure( solver );
+    }
+
+    Timer timer( true );
+    size_t repeats = 0;
+    do {
+        solver.solve();
+        repeats++;
+    } while( timer.getSeconds() < HARNESS_MIN_WALL_TIME );
+    timer.stop();
+
+    Result result;
+    result.mIntegrator = integrator.mName;
+    result.mH = h;
+    result.mTolerance = tolerance;
+    result.mIsStable = true;
+    result.mMaxError = 0.0;
+    result.mValidTime = HARNESS_TRACK_SPAN;
+    result.mRhsPerTime = double( solver.getRhsEvaluations() ) / HARNESS_TRACK_SPAN;
+    result.mWallPerTime = timer.getSeconds() / repeats / HARNESS_TRACK_SPAN;
+    result.mIsPareto = false;
+
+    const vector<Vec3f> &solutions = solver.getSolutions();
+    bool lost = false;
+    for( size_t i=0; i<numSamples && i<solutions.size(); i++ ) {
+        Vec3d u( solutions[i].x, solutions[i].y, solutions[i].z );
+        double error = u.distance( mReference[i] );
+        if( ! ( error < 1.0e6 ) ) {     // also catches NaN and infinity
+            result.mIsStable = false;
+            error = numeric_limits<double>::infinity();
+        }
+        if( i <= errorSamples ) {
+            result.mMaxError = max( result.mMaxError, error );
+        }
+        if( ! lost && error > HARNESS_LOST_DISTANCE ) {
+            lost = true;
+            result.mValidTime = i * HARNESS_SAMPLE_INTERVAL;
+        }
+        if( ! result.mIsStable ) break;
+    }
+    return result;
+}
+
+
+// A run is on the Pareto front if no other run has both less or equal
+// error and less or equal cost, and is strictly better in one of them.
+//
+void IntegratorHarness::markPareto()
+{
+    for( size_t i=0; i<mResults.size(); i++ ) {
+        Result &a = mResults[i];
+        a.mIsPareto = a.mIsStable;
+        for( size_t j=0; j<mResults.size() && a.mIsPareto; j++ ) {
+            const Result &b = mResults[j];
+            if( j == i || ! b.mIsStable ) continue;
+            bool noWorse = b.mMaxError <= a.mMaxError && b.mRhsPerTime <= a.mRhsPerTime;
+            bool better = b.mMaxError < a.mMaxError || b.mRhsPerTime < a.mRhsPerTime;
+            if( noWorse && better ) {
+                a.mIsPareto = false;
+            }
+        }
+    }
+}
+
+
+void IntegratorHarness::printTable( ostream &out ) const
+{
+    ios::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+    out << left << setw(10) << "method" << right << setw(10) << "H / tol" << setw(14) << "max error"
+        << setw(12) << "valid time" << setw(14) << "RHS evals/t" << setw(14) << "wall us/t" << "  Pareto" << endl;
+    for( size_t i=0; i<mResults.size(); i++ ) {
+        const Result &r = mResults[i];
+        out.unsetf( ios::floatfield );
+        out << left << setw(10) << r.mIntegrator << right << setprecision(4) << setw(10) << ( r.mTolerance > 0.0 ? r.mTolerance : r.mH );
+        if( r.mIsStable ) {
+            out << scientific << setprecision(3) << setw(14) << r.mMaxError
+                << fixed << setprecision(2) << setw(12) << r.mValidTime;
+        } else {
+            out << setw(14) << "unstable" << setw(12) << "-";
+        }
+        out << fixed << setprecision(0) << setw(14) << r.mRhsPerTime
+            << setprecision(1) << setw(14) << r.mWallPerTime * 1.0e6
+            << ( r.mIsPareto ? "  *" : "" ) << endl;
+    }
+    out.flags( flags );
+    out.precision( precision );
+}
+
+
+// For every run of the other integrators: the cheapest (by wall time) run of
+// the baseline with the same or smaller error, and how much faster the run is.
+//
+void IntegratorHarness::printMatchedError( ostream &out, const string &baseline ) const
+{
+    ios::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+    out << "At matched error, against the cheapest " << baseline << " run at least as accurate:" << endl;
+    for( size_t i=0; i<mResults.size(); i++ ) {
+        const Result &r = mResults[i];
+        if( r.mIntegrator == baseline || ! r.mIsStable ) continue;
+        const Result *best = NULL;
+        for( size_t j=0; j<mResults.size(); j++ ) {
+            const Result &b = mResults[j];
+            if( b.mIntegrator != baseline || ! b.mIsStable || b.mMaxError > r.mMaxError ) continue;
+            if( best == NULL || b.mWallPerTime < best->mWallPerTime ) best = &b;
+        }
+        out.unsetf( ios::floatfield );
+        out << "  " << left << setw(10) << r.mIntegrator << right << setprecision(4) << setw(10) << ( r.mTolerance > 0.0 ? r.mTolerance : r.mH )
+            << "  error " << scientific << setprecision(3) << r.mMaxError;
+        if( best == NULL ) {
+            out << ": no " << baseline << " run reaches it" << endl;
+        } else {
+            out.unsetf( ios::floatfield );
+            out << ": " << baseline << " needs H=" << setprecision(4) << best->mH << fixed << setprecision(2)
+                << ", wall time x" << best->mWallPerTime / r.mWallPerTime
+                << ", RHS evaluations x" << best->mRhsPerTime / r.mRhsPerTime << endl;
+        }
+    }
+    out.flags( flags );
+    out.precision( precision );
+}
+
+
+void IntegratorHarness::writeCsv( const fs::path &path ) const
+{
+    ofstream out( path.string().c_str() );
+    out << "integrator,h,max_error,valid_time,rhs_per_time,wall_us_per_time,stable,pareto,tolerance" << endl;
+    out << setprecision(9);
+    for( size_t i=0; i<mResults.size(); i++ ) {
+        const Result &r = mResults[i];
+        out << r.mIntegrator << "," << r.mH << ",";
+        if( r.mIsStable ) {
+            out << r.mMaxError << "," << r.mValidTime;
+        } else {
+            out << "nan,nan";
+        }
+        out << "," << r.mRhsPerTime << "," << r.mWallPerTime * 1.0e6 << "," << (r.mIsStable ? 1 : 0) << "," << (r.mIsPareto ? 1 : 0) << "," << r.mTolerance << endl;
+    }
+}
+
+
+// A gnuplot script plotting error against cost, one line per integrator,
+// the Pareto front circled.
+//
+void IntegratorHarness::writeGnuplot( const fs::path &scriptPath, const fs::path &csvPath, const fs::path &plotPath ) const
+{
+    ofstream out( scriptPath.string().c_str() );
+    out << "set datafile separator ','" << endl
+        << "set terminal pngcairo size 1000,700" << endl
+        << "set output '" << plotPath.generic_string() << "'" << endl
+        << "set logscale xy" << endl
+        << "set xlabel 'RHS evaluations per time unit'" << endl
+        << "set ylabel 'max error over t <= " << HARNESS_ERROR_SPAN << "'" << endl
+        << "set key left bottom" << endl
+        << "data = '" << csvPath.generic_string() << "'" << endl
+        << "plot \\" << endl;
+    for( size_t k=0; k<mIntegrators.size(); k++ ) {
+        out << "  data using (strcol(1) eq '" << mIntegrators[k].mName << "' ? $5 : 1/0):3 with linespoints title '"
+            << mIntegrators[k].mName << "', \\" << endl;
+    }
+    out << "  data using ($8 == 1 ? $5 : 1/0):3 with points pt 6 ps 2 lc rgb 'black' title 'Pareto front'" << endl;
+}
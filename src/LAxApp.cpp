@@ -12,6 +12,8 @@
 #include "cinder/Text.h"
 #include "cinder/Font.h"
 #include "cinder/params/Params.h"
+#include "cinder/gl/Fbo.h"
+#include "cinder/Timer.h"
 
 
 #include <deque>
@@ -22,6 +24,16 @@
 #include "Resources.h"
 #include "SphereMeshModel.h"
 #include "LorenzSolver.h"
+#include "FrameCapture.h"
+#include "EnsembleMesh.h"
+#include "GlExtensions.h"
+#include "PackedTrajectoryMesh.h"
+#include "IntegratorHarness.h"
+#include "TubeMesh.h"
+#include "QualityController.h"
+#include "PararealSolver.h"
+#include "PointCloud.h"
+#include "StreamingBuffer.h"
 
 
 using namespace ci;
@@ -32,23 +44,87 @@ using namespace std;
 #define MODEL_SPHERE_SLICES 20
 
 #define MAX_STEPS   3000    // Max number of steps (solutions)
+#define FRAME_RATE  30.0f   // also the target of the quality control
 
+#define ENSEMBLE_MAX_TRAJECTORIES   64      // Max number of trajectories shown at once
+#define ENSEMBLE_SPHERE_STACKS      4       // coarser spheres for the ensemble view
+#define ENSEMBLE_SPHERE_SLICES      6
+#define ENSEMBLE_DEFAULT_SPREAD     0.001f  // initial X difference between neighbor trajectories
 
-#define LORENZ_DEFAULT_INITIAL_CONDITION    Vec3f(0.1f, 0.1f, 0.1f)
-#define LORENZ_DEFAULT_PARAM_S              10.0f
-#define LORENZ_DEFAULT_PARAM_R              30.0f
-#define LORENZ_DEFAULT_PARAM_B               3.0f
+#define SAMPLE_DEFAULT_TOLERANCE    0.5f    // adaptive sampling, chord deviation in pixels
+
+#define CAPTURE_DIRECTORY   "capture"   // relative to the application folder
+#define HARNESS_DIRECTORY   "harness"   // integrator harness output, likewise
+
+#define POINT_CLOUD_MAX_STEPS       2000000 // point cloud view, see PointCloud
+#define POINT_CLOUD_DEFAULT_STEPS   1000000
+
+#define PARAREAL_DEFAULT_STEPS  10000000    // over PARAREAL_DEFAULT_SPAN
+
+
+enum VertexFormat {
+    VERTEX_FORMAT_FLOAT,        // the Cinder VBO mesh: float positions, normals and colors
+    VERTEX_FORMAT_PACKED,       // PackedTrajectoryMesh, float positions
+    VERTEX_FORMAT_PACKED_HALF   // PackedTrajectoryMesh, half float positions
+};
+
+enum QualityKnob {             // in the order added to the QualityController
+    QUALITY_SPHERE_DETAIL,      // sphere level of detail, 0 the coarsest; float format with 16-bit indices only
+    QUALITY_STRIDE,             // integration steps per rendered step
+    QUALITY_REFINEMENT,         // adaptive sampling: halvings of the coarsest spacing
+    QUALITY_STEPS               // cap on the rendered steps; the solver still integrates all of them
+};
+
+#define QUALITY_DEFAULT_MIN_STEPS       500
+#define QUALITY_DEFAULT_MAX_REFINEMENT  3
+
+enum RenderMode {
+    RENDER_SPHERES,             // a sphere per step (or sample)
+    RENDER_TUBE,                // TubeMesh, swept along the trajectory
+    RENDER_POINTS               // PointCloud, a point sprite per step, up to POINT_CLOUD_MAX_STEPS
+};
 
 struct LorenzParams {
     int32_t mNumSteps;
-    bool    mUseRK4;
+    int32_t mIntegrator;            // LorenzSolver::Integrator
+    int32_t mTaylorOrder;
+    int32_t mTaylorToleranceExp;    // tolerance = 10^exp
     Vec3f   mInitialCondition;
-    float   mParam_S, mParam_R, mParam_B;
+    int32_t mSystem;                // AttractorSystem
+    float   mSystemParams[ATTRACTOR_COUNT][ATTRACTOR_MAX_PARAMS];  // each system keeps its own
     bool    mAutoIncementX;
     bool    mFindROP; // ROP: "range of predictability"
 };
 
 
+// Would the two parameter sets give the same trajectory?
+static bool isSameTrajectory( const LorenzParams &a, const LorenzParams &b )
+{
+    return a.mIntegrator == b.mIntegrator && a.mTaylorOrder == b.mTaylorOrder && a.mTaylorToleranceExp == b.mTaylorToleranceExp
+        && a.mInitialCondition == b.mInitialCondition && a.mSystem == b.mSystem
+        && equal( a.mSystemParams[a.mSystem], a.mSystemParams[a.mSystem] + ATTRACTOR_MAX_PARAMS, b.mSystemParams[b.mSystem] );
+}
+
+
+// Color by step (time): starting blue, each following solution gets warmer.
+static Color stepColor( uint32_t step )
+{
+    Color clr;
+    clr.r = float(step)/float(MAX_STEPS);
+    clr.b = 1.0f - clr.r;
+    clr.g = 0.33f;
+    return clr;
+}
+
+
+// ...the same, as the RGBA8 of the sphere color buffer
+static ColorA8u stepColor8u( uint32_t step )
+{
+    Color c = stepColor( step );
+    return ColorA8u( uint8_t(c.r*255.0f), uint8_t(c.g*255.0f), uint8_t(c.b*255.0f), 255 );
+}
+
+
 class LAxApp : public AppNative 
 {
 private:
@@ -62,7 +138,43 @@ private:
     SphereMeshModel    mSphereModel;
     gl::VboMesh        mModelMesh;
     int32_t            mIndicesPerSphere;
+    bool               mUseSphereIndices16;     // one 16-bit sphere index list + base vertex draws
+    gl::Vbo            mSphereIndexVbo;         // ...that list, followed by the coarser levels of detail
+    vector<GLsizei>    mSphereLodCounts;        // ...their number of indices
+    vector<size_t>     mSphereLodOffsets;       // ...and byte offsets
+    int32_t            mSphereLod;              // level the multi-draw arguments below are set for
+    vector<GLsizei>    mSphereIndexCounts;      // ...the per-sphere multi-draw arguments
+    vector<const GLvoid*> mSphereIndexOffsets;
+    vector<GLint>      mSphereBaseVertices;
+    gl::Vbo            mSphereColorVbo;         // per-vertex step colors, RGBA8, kept apart from the streamed positions
+    vector<uint32_t>   mUploadedSteps;          // ...the steps the color buffer holds
+    vector<ColorA8u>   mStagingColors;          // its dirty range, before it is uploaded
+    StreamingBuffer    mSphereStream;           // sphere positions
+    vector<Vec3f>      mRegionCenters[STREAMING_REGIONS];   // ...the sphere centers each of its regions holds
+    bool               mPersistentUpload;       // the persistent ring, where the context supports it
+    string             mUploadPath;
+    int32_t            mSphereUploadBytes;      // written to the sphere buffers by the last update
+    float              mUploadTime;             // ms, mapping and writing the positions
+    float              mUploadWait;             // ms of that, waiting for the GPU
+    int32_t            mVertexFormat;           // VertexFormat
+    PackedTrajectoryMesh mPackedMesh;
     int32_t            mModelNumElements;
+    int32_t            mSampling;               // LorenzSolver::Sampling
+    float              mSampleSpacing;          // phase space units
+    float              mSampleTolerance;        // pixels
+    int32_t            mNumSpheresDrawn;
+    int32_t            mNumTrianglesDrawn;
+    int32_t            mRenderMode;             // RenderMode
+    TubeMesh           mTubeMesh;
+    PointCloud         mPointCloud;
+    int32_t            mPointCloudSteps;
+    LorenzParams       mPointCloudParams;       // ...that the point cloud was solved for
+    int32_t            mPointCloudStride;
+    QualityController  mQuality;
+    bool               mQualityControl;
+    int32_t            mQualityMinSteps;        // user bounds of the knobs
+    int32_t            mQualityMaxStride;
+    int32_t            mQualityMaxRefinement;
     Vec3f              mCenterPos;
     int32_t            mIterationCnt;
     bool               mIterativeDraw;
@@ -71,17 +183,36 @@ private:
     Rand               mRand;
     bool               mViewModelEnabled;
     bool               mAutoRotate;
+    bool               mEnsembleMode;
+    int32_t            mEnsembleSize;
+    float              mEnsembleSpread;
+    EnsembleMesh       mEnsembleMesh;
+    vector<Vec3f>      mEnsembleSolutions;
+    LorenzParams       mEnsembleParams;         // ...that the ensemble was solved for
+    int32_t            mEnsembleSolvedSize;
+    float              mEnsembleSolvedSpread;
+    int32_t            mEnsembleStride;
    
     params::InterfaceGlRef	mParams;
     LorenzParams       mLorenzParams, mOrigParams;
+    int32_t            mShownSystem;            // whose parameters the params panel shows
     float              mAverageFps;
     float              mSi;
 
+    FrameCapture       mFrameCapture;
+    gl::Fbo            mCaptureFbo;         // offline capture target, see startCapture()
+    int32_t            mCaptureFormat;      // FrameCapture::Format
+    bool               mCaptureOffline;
+    int32_t            mCaptureFrameLimit;  // 0: until stopped
+    bool               mQuitAfterCapture;
+    bool               mBatchRun;           // "--integrator-harness" or "--parareal": no model, params or frames
+
 
 public:
 
     void  prepareSettings( Settings *settings );
     void  setup();
+    void  shutdown();
     void  update();
     void  draw();
     void  resize();
@@ -93,9 +224,26 @@ private:
 
     void  ppl_initModel();
     void  initModel();
+    void  initSphereMesh();
+    void  releaseSphereMesh();
+    void  updateEnsemble();
+    void  drawSpheres( int32_t numSpheres );
+    void  showSystemParams();
+    void  initSphereStream();
+    void  updateSpheres( const vector<Vec3f> &centers, const vector<uint32_t> &steps );
+    void  updatePackedMesh( const vector<Vec3f> &positions, const vector<uint32_t> &steps );
+    void  updateTube( const vector<Vec3f> &positions, const vector<uint32_t> &steps );
+    void  updatePointCloud();
+    void  applyQuality();
+    void  reportVertexPrecision();
+    void  runIntegratorHarness();
+    void  runPararealBenchmark( size_t numSteps );
     void  updateCameraPerspective();
     void  rotateModel( float leftRight, float upDown );
     void  zoom( float w );
+    void  drawScene();
+    void  startCapture();
+    void  stopCapture();
 
 };
 
@@ -108,7 +256,7 @@ void LAxApp::prepareSettings( Settings *settings )
 {
     // Window size and frame rate
     settings->setWindowSize( 1280, 720 );
-    settings->setFrameRate( 30.0f );
+    settings->setFrameRate( FRAME_RATE );
     settings->setTitle( "LAx" );
     settings->enableConsoleWindow(true);
 }
@@ -120,22 +268,84 @@ void LAxApp::prepareSettings( Settings *settings )
 */
 void LAxApp::setup()
 {
+    mBatchRun = false;
+
     // Random numbers generator
     mRand = Rand();
 
     //Initial model params
     mLorenzParams.mNumSteps = MAX_STEPS;
-    mLorenzParams.mUseRK4 = true;
-    mLorenzParams.mInitialCondition = LORENZ_DEFAULT_INITIAL_CONDITION;
-    mLorenzParams.mParam_S = LORENZ_DEFAULT_PARAM_S;
-    mLorenzParams.mParam_R = LORENZ_DEFAULT_PARAM_R;
-    mLorenzParams.mParam_B = LORENZ_DEFAULT_PARAM_B;
+    mLorenzParams.mIntegrator = LorenzSolver::INTEGRATOR_RK4;
+    mLorenzParams.mTaylorOrder = DEFAULT_TAYLOR_ORDER;
+    mLorenzParams.mTaylorToleranceExp = -10;
+    mLorenzParams.mSystem = ATTRACTOR_LORENZ;
+    for( int32_t s=0; s<ATTRACTOR_COUNT; s++ ) {
+        const AttractorInfo &info = getAttractorInfo( AttractorSystem(s) );
+        for( size_t p=0; p<ATTRACTOR_MAX_PARAMS; p++ ) {
+            mLorenzParams.mSystemParams[s][p] = ( p < info.mNumParams ) ? info.mParams[p].mDefault : 0.0f;
+        }
+    }
+    mLorenzParams.mInitialCondition = getAttractorInfo( ATTRACTOR_LORENZ ).mInitialCondition;
     mLorenzParams.mAutoIncementX = false;
     mOrigParams = mLorenzParams;
     mSi = 0.0f;
 
     mViewModelEnabled = true; // currently not used
     mAutoRotate = false;
+    mEnsembleMode = false;
+    mEnsembleSize = 16;
+    mEnsembleSpread = ENSEMBLE_DEFAULT_SPREAD;
+    mEnsembleSolvedSize = 0;
+    mEnsembleSolvedSpread = 0.0f;
+    mEnsembleStride = 0;
+    mVertexFormat = VERTEX_FORMAT_FLOAT;
+    mSampling = LorenzSolver::SAMPLING_STRIDE;
+    mSampleSpacing = DEFAULT_SAMPLE_SPACING;
+    mSampleTolerance = SAMPLE_DEFAULT_TOLERANCE;
+    mNumSpheresDrawn = 0;
+    mNumTrianglesDrawn = 0;
+    mSphereUploadBytes = 0;
+    mUploadTime = 0.0f;
+    mUploadWait = 0.0f;
+    mPersistentUpload = true;
+    mRenderMode = RENDER_SPHERES;
+    mPointCloudSteps = POINT_CLOUD_DEFAULT_STEPS;
+    mPointCloudStride = 0;
+    mQualityControl = false;
+    mQualityMinSteps = QUALITY_DEFAULT_MIN_STEPS;
+    mQualityMaxStride = 1;
+    mQualityMaxRefinement = QUALITY_DEFAULT_MAX_REFINEMENT;
+
+    // Frame capture: off until requested. "--capture-offline [frames]" on the
+    // command line records that many frames without a visible window and quits.
+    mCaptureFormat = FrameCapture::FORMAT_PNG;
+    mCaptureOffline = false;
+    mCaptureFrameLimit = 0;
+    mQuitAfterCapture = false;
+    const vector<string>& args = getArgs();
+    for( size_t i=1; i<args.size(); i++ ) {
+        if( args[i] == "--capture-offline" ) {
+            mCaptureOffline = true;
+            mQuitAfterCapture = true;
+            mCaptureFrameLimit = ( i+1 < args.size() ) ? atoi( args[i+1].c_str() ) : MAX_STEPS;
+            if( mCaptureFrameLimit <= 0 ) mCaptureFrameLimit = MAX_STEPS;
+        } else if( args[i] == "--orphan-upload" ) {
+            mPersistentUpload = false;
+        } else if( args[i] == "--capture-raw" ) {
+            mCaptureFormat = FrameCapture::FORMAT_RAW;
+        } else if( args[i] == "--parareal" ) {
+            size_t numSteps = ( i+1 < args.size() ) ? size_t( atof( args[i+1].c_str() ) ) : 0;
+            mBatchRun = true;
+            runPararealBenchmark( numSteps > 0 ? numSteps : PARAREAL_DEFAULT_STEPS );
+            quit();
+            return;     // no model or params for a batch run; update() and draw() skip it
+        } else if( args[i] == "--integrator-harness" ) {
+            mBatchRun = true;
+            runIntegratorHarness();
+            quit();
+            return;
+        }
+    }
 
     // CAMERA: ...
     mCamEyePoint = Vec3f( 30.6671f, -40.4094f, -33.9354f ); // initial eye point
@@ -147,8 +357,20 @@ void LAxApp::setup()
     // LIGHT Position:
     mLightPosition = Vec4f(50.0f, -270.0f, 230.0f, 1.0f);
 
+    // OpenGL entry points beyond what Cinder's GL headers provide
+    glext::init();
+
     // MODEL: Init the model, see initModel()
     initModel();
+
+    // QUALITY: the knobs start at their best; the bounds follow the params, see applyQuality()
+    // the coarser sphere levels need the 16-bit indices and base vertex draws
+    mQuality.addKnob( mUseSphereIndices16 ? "Sphere detail" : "Sphere detail (n/a, 32-bit indices)", QualityController::COST_RENDER, 
+        0, int32_t(mSphereLodCounts.size()) - 1 );
+    mQuality.addKnob( "Integration stride", QualityController::COST_SOLVE, 1, mQualityMaxStride );
+    mQuality.addKnob( "Sampling refinement", QualityController::COST_RENDER, 0, mQualityMaxRefinement );
+    mQuality.addKnob( "Steps", QualityController::COST_RENDER, mQualityMinSteps, MAX_STEPS, 250 );
+    mQuality.setTargetFps( FRAME_RATE );
     mIterationCnt = 0;
     mIterativeDraw = false;
     mCenterPos = Vec3f::zero(); // model center - will be updated later
@@ -186,24 +408,143 @@ void LAxApp::setup()
     stringstream ss;
     ss << "min=50 max=" << MAX_STEPS << " step=10 keyIncr=> keyDecr=<";
     mParams->addParam( "Steps to render", &mLorenzParams.mNumSteps, ss.str() );
-    mParams->addParam( "Lorenz system param S", &mLorenzParams.mParam_S, "min=1 max=50 step=0.1 keyIncr=S keyDecr=s" );
-    mParams->addParam( "Lorenz system param R", &mLorenzParams.mParam_R, "min=1 max=50 step=0.1 keyIncr=S keyDecr=s" );
-    mParams->addParam( "Lorenz system param B", &mLorenzParams.mParam_B, "min=1 max=50 step=0.1 keyIncr=S keyDecr=s" );
+    // the systems and their parameters, from the metadata; only the current system's are shown
+    vector<string> systems;
+    for( int32_t s=0; s<ATTRACTOR_COUNT; s++ ) {
+        systems.push_back( getAttractorInfo( AttractorSystem(s) ).mName );
+    }
+    mParams->addParam( "System", systems, &mLorenzParams.mSystem, "keyIncr=m" );
+    for( int32_t s=0; s<ATTRACTOR_COUNT; s++ ) {
+        const AttractorInfo &info = getAttractorInfo( AttractorSystem(s) );
+        for( size_t p=0; p<info.mNumParams; p++ ) {
+            const AttractorParam &param = info.mParams[p];
+            ss.str( "" );
+            ss << "min=" << param.mMin << " max=" << param.mMax << " step=" << param.mStep
+               << " group='" << info.mName << " parameters' label='" << param.mName << "'";
+            mParams->addParam( string( info.mName ) + " param " + param.mName, &mLorenzParams.mSystemParams[s][p], ss.str() );
+        }
+    }
+    showSystemParams();
     mParams->addParam( "Init condition X", &mLorenzParams.mInitialCondition.x, "min=-50 max=50 step=0.01 keyIncr=X keyDecr=x" );
     mParams->addParam( "Init condition Y", &mLorenzParams.mInitialCondition.y, "min=-50 max=50 step=0.01 keyIncr=Y keyDecr=y" );
     mParams->addParam( "Init condition Z", &mLorenzParams.mInitialCondition.z, "min=-50 max=50 step=0.01 keyIncr=Z keyDecr=z" );
     mParams->addParam( "Auto increment initial X by 0.001", &mLorenzParams.mAutoIncementX, "keyIncr=1" );
     mParams->addParam( "Find 'range of predictability'", &mLorenzParams.mFindROP, "keyIncr=p" );
-    mParams->addParam( "Use RK4 integration", &mLorenzParams.mUseRK4, "keyIncr=/" );
+    vector<string> integrators;
+    integrators.push_back( "Euler" );
+    integrators.push_back( "RK4" );
+    integrators.push_back( "Taylor (automatic step)" );
+    mParams->addParam( "Integrator", integrators, &mLorenzParams.mIntegrator, "keyIncr=/" );
+    mParams->addParam( "Taylor order", &mLorenzParams.mTaylorOrder, "min=10 max=30 step=1" );
+    mParams->addParam( "Taylor tolerance (10^x)", &mLorenzParams.mTaylorToleranceExp, "min=-14 max=-3 step=1" );
+    vector<string> samplings;
+    samplings.push_back( "Every step" );
+    samplings.push_back( "By arc length" );
+    samplings.push_back( "By arc length and curvature" );
+    mParams->addParam( "Sampling", samplings, &mSampling, "keyIncr=a" );
+    mParams->addParam( "Sample spacing", &mSampleSpacing, "min=0.05 max=5 step=0.05" );
+    mParams->addParam( "Curvature tolerance (pixels)", &mSampleTolerance, "min=0.1 max=10 step=0.1" );
+    vector<string> renderModes;
+    renderModes.push_back( "Spheres" );
+    renderModes.push_back( "Tube" );
+    renderModes.push_back( "Points (long trajectories)" );
+    mParams->addParam( "Render as", renderModes, &mRenderMode, "keyIncr=u" );
+    ss.str( "" );
+    ss << "min=10000 max=" << POINT_CLOUD_MAX_STEPS << " step=10000";
+    mParams->addParam( "Point cloud steps", &mPointCloudSteps, ss.str() );
+    mParams->addParam( "Ensemble view", &mEnsembleMode, "keyIncr=e" );
+    ss.str( "" );
+    ss << "min=1 max=" << ENSEMBLE_MAX_TRAJECTORIES << " step=1";
+    mParams->addParam( "Ensemble trajectories", &mEnsembleSize, ss.str() );
+    mParams->addParam( "Ensemble initial X spread", &mEnsembleSpread, "min=0 max=1 step=0.0001" );
+    vector<string> vertexFormats;
+    vertexFormats.push_back( "Float (28 bytes)" );
+    vertexFormats.push_back( "Packed (20 bytes)" );
+    vertexFormats.push_back( "Packed, half positions (16 bytes)" );
+    mParams->addParam( "Vertex format", vertexFormats, &mVertexFormat );
+    mParams->addButton( "Report vertex format precision", [this](){ reportVertexPrecision(); } );
     mParams->addSeparator();
     mParams->addButton( "Random initial condition", [this](){mLorenzParams.mInitialCondition = mRand.nextFloat(50.0f) * mRand.nextVec3f();}, "keyIncr=r" );
     mParams->addButton( "Random rotation", [this](){rotateModel(mRand.nextFloat(6.28f),mRand.nextFloat(6.28f));}, "keyIncr=t" );
     mParams->addButton( "Start iterative draw", [this](){mIterationCnt = 0;mIterativeDraw = true;}, "keyIncr=." );
     mParams->addButton( "Reset model", [this](){mLorenzParams=mOrigParams;}, "keyIncr=0" );
+    mParams->addButton( "Run integrator harness", [this](){ runIntegratorHarness(); } );
+    mParams->addButton( "Run Parareal benchmark", [this](){ runPararealBenchmark( PARAREAL_DEFAULT_STEPS ); } );
     //Vec3f rv = mRand.nextFloat(70.0f) * mRand.nextVec3f();
     mParams->addSeparator();
     mParams->addParam( "Last solution variance in time", &mSi, "step=0.01", true );
     mParams->addParam( "Frames per seconf (FPS)", &mAverageFps, "step=0.1", true );
+    mParams->addParam( "Spheres (tube rings) drawn", &mNumSpheresDrawn, "", true );
+    mParams->addParam( "Triangles drawn", &mNumTrianglesDrawn, "", true );
+    mParams->addParam( "Persistent mapped upload", &mPersistentUpload );
+    mParams->addParam( "Position upload path", &mUploadPath, "", true );
+    mParams->addParam( "Sphere bytes uploaded", &mSphereUploadBytes, "", true );
+    mParams->addParam( "Upload time (ms)", &mUploadTime, "precision=3", true );
+    mParams->addParam( "Upload GPU wait (ms)", &mUploadWait, "precision=3", true );
+    mParams->addSeparator();
+    mParams->addParam( "Adaptive quality", &mQualityControl, "keyIncr=q" );
+    ss.str( "" );
+    ss << "min=50 max=" << MAX_STEPS << " step=50";
+    mParams->addParam( "Quality: min steps", &mQualityMinSteps, ss.str() );
+    mParams->addParam( "Quality: max stride", &mQualityMaxStride, "min=1 max=100 step=1" );
+    mParams->addParam( "Quality: max refinement", &mQualityMaxRefinement, "min=0 max=6 step=1" );
+    for( size_t k=0; k<mQuality.getNumKnobs(); k++ ) {
+        mParams->addParam( "Now: " + mQuality.getName( k ), mQuality.getValuePtr( k ), "", true );
+    }
+    mParams->addSeparator();
+    vector<string> captureFormats;
+    captureFormats.push_back( "PNG sequence" );
+    captureFormats.push_back( "Raw RGBA stream" );
+    mParams->addParam( "Capture format", captureFormats, &mCaptureFormat );
+    mParams->addParam( "Capture offline (uncapped FPS)", &mCaptureOffline );
+    mParams->addButton( "Start/stop capture", [this](){ mFrameCapture.isCapturing() ? stopCapture() : startCapture(); }, "keyIncr=c" );
+
+    if( mQuitAfterCapture ) {
+        mIterationCnt = 0;
+        mIterativeDraw = true;
+        getWindow()->hide();
+        startCapture();
+    }
+}
+
+
+/*
+** Called when the application quits; finish any capture in progress.
+*/
+void LAxApp::shutdown()
+{
+    mFrameCapture.stop();
+}
+
+
+/*
+** Start recording frames. In offline mode the scene is rendered into an
+** FBO of the current window size and the frame rate limit is lifted, so
+** frames are produced as fast as the GPU and the encoder allow. All the 
+** animations (rotation, auto increment, iterative draw) advance by a fixed 
+** amount per frame, so an offline recording plays back the same as on screen.
+*/
+void LAxApp::startCapture()
+{
+    int32_t w = getWindowWidth();
+    int32_t h = getWindowHeight();
+    if( mCaptureOffline ) {
+        mCaptureFbo = gl::Fbo( w, h );
+        disableFrameRate();
+    }
+    mFrameCapture.start( getAppPath() / CAPTURE_DIRECTORY, w, h, FrameCapture::Format(mCaptureFormat) );
+    console() << "Capture started: " << w << "x" << h << (mCaptureOffline ? ", offline" : "") << endl;
+}
+
+
+void LAxApp::stopCapture()
+{
+    mFrameCapture.stop();
+    mCaptureFbo = gl::Fbo();
+    setFrameRate( FRAME_RATE );
+    if( mQuitAfterCapture ) {
+        quit();
+    }
 }
 
 
@@ -217,6 +558,12 @@ void LAxApp::setup()
 **   o The Cinder VBO mesh that holds everything together and interfaces with OpenGL.
 **
 ** In this implementation we have dynamic positions and color; static vertices & normals.
+**
+** Every sphere has the same indices, only shifted by its first vertex. When 
+** the GL context can draw with a base vertex, we keep a single 16-bit index 
+** list for one sphere and draw all spheres from it (see drawSpheres()), 
+** so the index buffer no longer grows with the number of steps. Otherwise 
+** the full 32-bit index buffer is built, as before.
 */
 void LAxApp::initModel ()
 {
@@ -228,27 +575,428 @@ void LAxApp::initModel ()
     // here we put the different parts of the model together;
     mModelNumElements = MAX_STEPS;
     mIndicesPerSphere = 6 * MODEL_SPHERE_SLICES * (MODEL_SPHERE_STACKS-1);
+    mUseSphereIndices16 = glext::hasDrawElementsBaseVertex();
+    initSphereMesh();
+}
+
+
+/*
+** The buffers of the float sphere mesh: normals, indices, step colors and
+** the position stream. A packed vertex format draws from buffers of its
+** own, so these are released while it is active, see releaseSphereMesh().
+*/
+void LAxApp::initSphereMesh()
+{
     uint32_t nVerticesPerSphere= MODEL_SPHERE_SLICES * (MODEL_SPHERE_STACKS-1) + 2;
     uint32_t nVertices = mModelNumElements * nVerticesPerSphere;
     uint32_t nIndices  = mModelNumElements * mIndicesPerSphere;
     gl::VboMesh::Layout layout;
-    layout.setStaticIndices();
+    if( ! mUseSphereIndices16 ) {
+        layout.setStaticIndices();
+    }
     layout.setStaticNormals();
-    layout.setDynamicPositions();
-    layout.setDynamicColorsRGB();
-    vector<uint32_t> indices;
-    indices.reserve( nIndices );  // this saves the vector from having to grow many times
     vector<Vec3f> normals;
     normals.reserve( nVertices ); // this saves the vector from having to grow many times
     for( int32_t i=0; i<mModelNumElements; i++ ) {
         mSphereModel.getStaticNormals( normals );
-        mSphereModel.getStaticIndices( i * nVerticesPerSphere, indices );
     }
-    assert( nIndices == indices.size() );
     assert( nVertices == normals.size() );
-    mModelMesh = gl::VboMesh( nVertices, nIndices, layout, GL_TRIANGLES );
-    mModelMesh.bufferIndices( indices );
+    if( mUseSphereIndices16 ) {
+        // the full sphere first, then the coarser levels of detail on the same vertices
+        vector<uint32_t> decimations;
+        mSphereModel.getLodDecimations( decimations );
+        vector<uint16_t> sphereIndices;
+        mSphereLodOffsets.clear();
+        mSphereLodCounts.clear();
+        for( size_t l=0; l<decimations.size(); l++ ) {
+            mSphereLodOffsets.push_back( sphereIndices.size() * sizeof(uint16_t) );
+            mSphereModel.getStaticIndices( sphereIndices, decimations[l] );
+            mSphereLodCounts.push_back( GLsizei( sphereIndices.size() - mSphereLodOffsets.back() / sizeof(uint16_t) ) );
+        }
+        assert( mIndicesPerSphere == mSphereLodCounts[0] );
+        mSphereIndexVbo = gl::Vbo( GL_ELEMENT_ARRAY_BUFFER );
+        mSphereIndexVbo.bufferData( sphereIndices.size() * sizeof(uint16_t), &sphereIndices[0], GL_STATIC_DRAW );
+        mSphereIndexVbo.unbind();
+        mSphereLod = 0;
+        mSphereIndexCounts.assign( mModelNumElements, mIndicesPerSphere );
+        mSphereIndexOffsets.assign( mModelNumElements, (const GLvoid*) 0 );
+        mSphereBaseVertices.resize( mModelNumElements );
+        for( int32_t i=0; i<mModelNumElements; i++ ) {
+            mSphereBaseVertices[i] = i * nVerticesPerSphere;
+        }
+        mModelMesh = gl::VboMesh( nVertices, 0, layout, GL_TRIANGLES );
+        console() << "Sphere indices: 16 bit, " << sphereIndices.size() * sizeof(uint16_t) << " bytes" << endl;
+    } else {
+        vector<uint32_t> indices;
+        indices.reserve( nIndices );  // this saves the vector from having to grow many times
+        for( int32_t i=0; i<mModelNumElements; i++ ) {
+            mSphereModel.getStaticIndices( i * nVerticesPerSphere, indices );
+        }
+        assert( nIndices == indices.size() );
+        mModelMesh = gl::VboMesh( nVertices, nIndices, layout, GL_TRIANGLES );
+        mModelMesh.bufferIndices( indices );
+        // the indices of all spheres are one list: the full sphere is the only level of detail
+        mSphereLodCounts.assign( 1, mIndicesPerSphere );
+        mSphereLodOffsets.assign( 1, 0 );
+        mSphereLod = 0;
+        console() << "Sphere indices: 32 bit, " << indices.size() * sizeof(uint32_t) << " bytes" << endl;
+    }
     mModelMesh.bufferNormals( normals );
+    // the colors follow the step of each sphere, which only adaptive sampling changes
+    vector<ColorA8u> colors;
+    colors.reserve( nVertices );
+    mUploadedSteps.resize( mModelNumElements );
+    for( int32_t i=0; i<mModelNumElements; i++ ) {
+        mUploadedSteps[i] = i;
+        colors.insert( colors.end(), nVerticesPerSphere, stepColor8u( i ) );
+    }
+    mSphereColorVbo = gl::Vbo( GL_ARRAY_BUFFER );
+    mSphereColorVbo.bufferData( nVertices * sizeof(ColorA8u), &colors[0], GL_STATIC_DRAW );
+    mSphereColorVbo.unbind();
+    // the positions are streamed, see updateSpheres()
+    initSphereStream();
+}
+
+
+void LAxApp::releaseSphereMesh()
+{
+    mModelMesh = gl::VboMesh();
+    mSphereIndexVbo = gl::Vbo();
+    mSphereColorVbo = gl::Vbo();
+    mSphereStream.release();
+    for( size_t r=0; r<STREAMING_REGIONS; r++ ) {
+        mRegionCenters[r].clear();
+    }
+    console() << "Sphere mesh: float buffers released" << endl;
+}
+
+
+/*
+** Show the parameters of the current system only.
+*/
+void LAxApp::showSystemParams()
+{
+    for( int32_t s=0; s<ATTRACTOR_COUNT; s++ ) {
+        string group = string( getAttractorInfo( AttractorSystem(s) ).mName ) + " parameters";
+        mParams->setOptions( group, s == mLorenzParams.mSystem ? "visible=true" : "visible=false" );
+    }
+    mShownSystem = mLorenzParams.mSystem;
+}
+
+
+/*
+** (Re)create the position stream of the spheres, as the params ask; 
+** its regions start out empty.
+*/
+void LAxApp::initSphereStream()
+{
+    mSphereStream.init( mModelNumElements * mSphereModel.getNumVertices() * sizeof(Vec3f), mPersistentUpload );
+    for( size_t r=0; r<STREAMING_REGIONS; r++ ) {
+        mRegionCenters[r].clear();
+    }
+    mUploadPath = ( mSphereStream.getMode() == StreamingBuffer::MODE_PERSISTENT ) ? "persistent ring" : "orphaning";
+    console() << "Sphere positions: " << mUploadPath << endl;
+}
+
+
+/*
+** Bring the sphere buffers up to date with the given centers (and the
+** steps of adaptive samples, empty otherwise). While the region of the
+** position stream drawn last holds the centers, nothing is written: a
+** trajectory that stands still, or is drawn iteratively, costs nothing.
+** Otherwise the next region is mapped and only the range of spheres it
+** holds differently is written (all of them, when it was orphaned).
+** The colors are written only where adaptive samples have moved to
+** other steps.
+*/
+void LAxApp::updateSpheres( const vector<Vec3f> &centers, const vector<uint32_t> &steps )
+{
+    if( ! mModelMesh ) {
+        // back from a packed format
+        mPackedMesh = PackedTrajectoryMesh();
+        initSphereMesh();
+    } else if( mPersistentUpload != mSphereStream.isPersistentAllowed() ) {
+        initSphereStream();
+    }
+    const size_t n = min( centers.size(), size_t(mModelNumElements) );
+    const size_t verticesPerSphere = mSphereModel.getNumVertices();
+    mSphereUploadBytes = 0;
+    mUploadTime = 0.0f;
+    mUploadWait = 0.0f;
+
+    const vector<Vec3f> &drawn = mRegionCenters[mSphereStream.getRegion()];
+    if( drawn.size() < n || ! equal( centers.begin(), centers.begin() + n, drawn.begin() ) ) {
+        Timer uploadTimer( true );
+        Vec3f *positions = reinterpret_cast<Vec3f*>( mSphereStream.map() );
+        vector<Vec3f> &held = mRegionCenters[mSphereStream.getRegion()];
+        if( mSphereStream.getMode() != StreamingBuffer::MODE_PERSISTENT ) {
+            held.clear();
+        }
+        if( positions != NULL ) {
+            size_t first = n, last = 0;
+            for( size_t i=0; i<n; i++ ) {
+                if( i >= held.size() || centers[i] != held[i] ) {
+                    first = min( first, i );
+                    last = i + 1;
+                }
+            }
+            if( held.size() < n ) {
+                held.resize( n );
+            }
+            for( size_t i=first; i<last; i++ ) {
+                mSphereModel.updatePositions( positions + i * verticesPerSphere, centers[i] );
+                held[i] = centers[i];
+            }
+            mSphereStream.unmap();
+            if( first < last ) {
+                mSphereUploadBytes += int32_t( ( last - first ) * verticesPerSphere * sizeof(Vec3f) );
+            }
+        }
+        mUploadWait = float( 1000.0 * mSphereStream.getLastWaitTime() );
+        mUploadTime = float( 1000.0 * uploadTimer.getSeconds() );
+    }
+
+    size_t clrFirst = n, clrLast = 0;
+    for( size_t i=0; i<n; i++ ) {
+        uint32_t step = ( i < steps.size() ) ? steps[i] : uint32_t(i);
+        if( step != mUploadedSteps[i] ) {
+            clrFirst = min( clrFirst, i );
+            clrLast = i + 1;
+        }
+    }
+    if( clrFirst < clrLast ) {
+        mStagingColors.resize( ( clrLast - clrFirst ) * verticesPerSphere );
+        for( size_t i=clrFirst; i<clrLast; i++ ) {
+            uint32_t step = ( i < steps.size() ) ? steps[i] : uint32_t(i);
+            fill_n( &mStagingColors[( i - clrFirst ) * verticesPerSphere], verticesPerSphere, stepColor8u( step ) );
+            mUploadedSteps[i] = step;
+        }
+        mSphereColorVbo.bufferSubData( clrFirst * verticesPerSphere * sizeof(ColorA8u), mStagingColors.size() * sizeof(ColorA8u), &mStagingColors[0] );
+        mSphereColorVbo.unbind();
+        mSphereUploadBytes += int32_t( mStagingColors.size() * sizeof(ColorA8u) );
+    }
+}
+
+
+/*
+** Draw the first numSpheres spheres of the model. With the 16-bit sphere
+** indices, at the level of detail the quality control has set.
+*/
+void LAxApp::drawSpheres( int32_t numSpheres )
+{
+    numSpheres = min( numSpheres, mModelNumElements );
+    if( numSpheres <= 0 ) return;
+    if( mVertexFormat != VERTEX_FORMAT_FLOAT && mPackedMesh.isInitialized() ) {
+        mPackedMesh.draw( numSpheres );
+        return;
+    }
+    if( mUseSphereIndices16 ) {
+        int32_t lod = int32_t(mSphereLodCounts.size()) - 1 - mQuality.getValue( QUALITY_SPHERE_DETAIL );
+        if( lod != mSphereLod ) {
+            mSphereLod = lod;
+            mSphereIndexCounts.assign( mModelNumElements, mSphereLodCounts[lod] );
+            mSphereIndexOffsets.assign( mModelNumElements, (const GLvoid*) mSphereLodOffsets[lod] );
+        }
+    }
+    mModelMesh.enableClientStates();
+    mModelMesh.bindAllData();
+    // the positions and colors are not part of the VBO mesh layout
+    glEnableClientState( GL_VERTEX_ARRAY );
+    mSphereStream.bind();
+    glVertexPointer( 3, GL_FLOAT, sizeof(Vec3f), (const GLvoid*) mSphereStream.getOffset() );
+    glEnableClientState( GL_COLOR_ARRAY );
+    mSphereColorVbo.bind();
+    glColorPointer( 4, GL_UNSIGNED_BYTE, sizeof(ColorA8u), 0 );
+    if( mUseSphereIndices16 ) {
+        mSphereIndexVbo.bind();
+        glext::multiDrawElementsBaseVertex( GL_TRIANGLES, &mSphereIndexCounts[0], GL_UNSIGNED_SHORT, &mSphereIndexOffsets[0], numSpheres, &mSphereBaseVertices[0] );
+        mSphereIndexVbo.unbind();
+    } else {
+        glDrawElements( GL_TRIANGLES, numSpheres * mIndicesPerSphere, GL_UNSIGNED_INT, 0 );
+    }
+    mSphereStream.fence();
+    glDisableClientState( GL_VERTEX_ARRAY );
+    glDisableClientState( GL_COLOR_ARRAY );
+    gl::VboMesh::unbindBuffers();
+    mModelMesh.disableClientStates();
+}
+
+
+/*
+** Stream the solution into the compact vertex layout, (re)building 
+** it first when the selected format has changed. The sphere colors 
+** depend on the step only, so they are set once per build, unless 
+** the spheres are adaptive samples (steps not empty), whose steps 
+** change from frame to frame.
+*/
+void LAxApp::updatePackedMesh( const vector<Vec3f> &positions, const vector<uint32_t> &steps )
+{
+    // the format the context can draw; the mesh is rebuilt only when that changes
+    PackedTrajectoryMesh::PositionFormat format = PackedTrajectoryMesh::getSupportedFormat( 
+        ( mVertexFormat == VERTEX_FORMAT_PACKED_HALF ) ? PackedTrajectoryMesh::POSITION_HALF : PackedTrajectoryMesh::POSITION_FLOAT );
+    bool rebuild = ! mPackedMesh.isInitialized() || mPackedMesh.getFormat() != format;
+    Timer uploadTimer( true );
+    mPackedMesh.resetUploadBytes();
+    if( rebuild ) {
+        if( mModelMesh ) {
+            releaseSphereMesh();
+        }
+        mPackedMesh.init( mModelNumElements, mSphereModel, format );
+    }
+    if( rebuild || ! steps.empty() ) {
+        vector<Colorf> colors( mModelNumElements );
+        for( int32_t i=0; i<mModelNumElements; i++ ) {
+            colors[i] = stepColor( size_t(i) < steps.size() ? steps[i] : uint32_t(i) );
+        }
+        mPackedMesh.setSphereColors( colors );
+    }
+    mPackedMesh.update( positions );
+    mSphereUploadBytes = int32_t( mPackedMesh.getUploadBytes() );
+    mUploadTime = float( 1000.0 * uploadTimer.getSeconds() );
+    mUploadWait = 0.0f;
+}
+
+
+/*
+** Sweep the tube along the solution (or the adaptive samples). The tube
+** is built when first needed; afterwards only the part of it that 
+** changed since the last frame is rebuilt and uploaded.
+*/
+void LAxApp::updateTube( const vector<Vec3f> &positions, const vector<uint32_t> &steps )
+{
+    if( ! mTubeMesh.isInitialized() ) {
+        mTubeMesh.init( mModelNumElements );
+        vector<Colorf> colors( MAX_STEPS );
+        for( int32_t i=0; i<MAX_STEPS; i++ ) {
+            colors[i] = stepColor( i );
+        }
+        mTubeMesh.setStepColors( colors );
+    }
+    mTubeMesh.update( positions, steps );
+}
+
+
+/*
+** Solve the long trajectory of the point cloud straight into its buffer,
+** with the integration settings of the main solver; only when something
+** it depends on has changed, so a still trajectory costs nothing.
+*/
+void LAxApp::updatePointCloud()
+{
+    if( ! mPointCloud.isInitialized() ) {
+        mPointCloud.init( POINT_CLOUD_MAX_STEPS );
+    }
+    int32_t stride = mQuality.getValue( QUALITY_STRIDE );
+    if( mPointCloud.getNumPoints() == size_t(mPointCloudSteps) && mPointCloudStride == stride
+        && isSameTrajectory( mPointCloudParams, mLorenzParams ) ) {
+        return;
+    }
+    Timer solveTimer( true );
+    mPointCloud.update( mSolver, mPointCloudSteps );
+    mQuality.addSolveTime( solveTimer.getSeconds() );
+    mPointCloudParams = mLorenzParams;
+    mPointCloudStride = stride;
+}
+
+
+/*
+** Hand the user bounds to the quality control. The refinement knob only
+** means something with adaptive sampling; otherwise it is held at its best.
+*/
+void LAxApp::applyQuality()
+{
+    mQuality.setEnabled( mQualityControl );
+    // the packed formats draw the full spheres
+    mQuality.setBounds( QUALITY_SPHERE_DETAIL, 0, ( mVertexFormat == VERTEX_FORMAT_FLOAT ) ? int32_t(mSphereLodCounts.size()) - 1 : 0 );
+    mQuality.setBounds( QUALITY_STRIDE, 1, mQualityMaxStride );
+    bool adaptive = mSampling != LorenzSolver::SAMPLING_STRIDE;
+    mQuality.setBounds( QUALITY_REFINEMENT, adaptive ? 0 : mQualityMaxRefinement, mQualityMaxRefinement );
+    mQuality.setBounds( QUALITY_STEPS, min( mQualityMinSteps, MAX_STEPS ), MAX_STEPS );
+}
+
+
+/*
+** Print to the console how much the compact vertex format saves and 
+** how much precision it loses, for the current solution.
+*/
+void LAxApp::reportVertexPrecision()
+{
+    if( mVertexFormat == VERTEX_FORMAT_FLOAT ) {
+        console() << "Vertex format: float, 28 bytes per vertex (12 streamed, changed spheres only); select a packed format to compare" << endl;
+        return;
+    }
+    bool adaptive = mSolver.getSampling() != LorenzSolver::SAMPLING_STRIDE;
+    vector<Vec3f>& spheres = adaptive ? mSolver.getSamples() : mSolver.getSolutions();
+    updatePackedMesh( spheres, mSolver.getSampleSteps() );
+    mPackedMesh.measurePrecision( spheres, console() );
+}
+
+
+/*
+** Compare the integrators over a grid of H, for the current parameters 
+** and initial condition; see IntegratorHarness. The table goes to the 
+** console, the CSV and a gnuplot script for the plot to HARNESS_DIRECTORY.
+*/
+void LAxApp::runIntegratorHarness()
+{
+    // the harness and its reference are for the Lorenz system
+    const float *p = mLorenzParams.mSystemParams[ATTRACTOR_LORENZ];
+    Vec3f initCondition = ( mLorenzParams.mSystem == ATTRACTOR_LORENZ ) ? mLorenzParams.mInitialCondition : getAttractorInfo( ATTRACTOR_LORENZ ).mInitialCondition;
+    IntegratorHarness harness( p[0], p[1], p[2], initCondition );
+    harness.addDefaultIntegrators();
+    harness.run( console() );
+    harness.printTable( console() );
+    harness.printMatchedError( console(), "RK4" );
+    fs::path dir = getAppPath() / HARNESS_DIRECTORY;
+    fs::create_directories( dir );
+    harness.writeCsv( dir / "integrators.csv" );
+    harness.writeGnuplot( dir / "integrators.gp", dir / "integrators.csv", dir / "integrators.png" );
+    console() << "Integrator harness results written to " << dir << " (plot: gnuplot integrators.gp)" << endl;
+}
+
+
+/*
+** Integrate numSteps RK4 steps over PARAREAL_DEFAULT_SPAN time units from 
+** the current initial condition, time-parallel and serially, and print 
+** the comparison to the console; see PararealSolver. "--parareal [steps]" 
+** on the command line does the same and quits (1e8 is accepted).
+*/
+void LAxApp::runPararealBenchmark( size_t numSteps )
+{
+    PararealSolver parareal( DEFAULT_PAR_S, DEFAULT_PAR_R, DEFAULT_PAR_B );
+    parareal.setSystem( AttractorSystem( mLorenzParams.mSystem ), mLorenzParams.mSystemParams[mLorenzParams.mSystem] );
+    parareal.setFine( LorenzSolver::INTEGRATOR_RK4, float( PARAREAL_DEFAULT_SPAN / numSteps ) );
+    parareal.benchmark( mLorenzParams.mInitialCondition, numSteps, console() );
+}
+
+
+/*
+** Solve and upload the ensemble: mEnsembleSize trajectories starting 
+** mEnsembleSpread apart along X from the current initial condition.
+** The ensemble buffers are big, so they are only built when first needed.
+*/
+void LAxApp::updateEnsemble()
+{
+    if( ! mEnsembleMesh.isInitialized() ) {
+        mEnsembleMesh.init( ENSEMBLE_MAX_TRAJECTORIES, MAX_STEPS, SphereMeshModel( ENSEMBLE_SPHERE_SLICES, ENSEMBLE_SPHERE_STACKS, 0.8f ) );
+    }
+    int32_t stride = mQuality.getValue( QUALITY_STRIDE );
+    if( mEnsembleSolvedSize == mEnsembleSize && mEnsembleSolvedSpread == mEnsembleSpread && mEnsembleStride == stride
+        && isSameTrajectory( mEnsembleParams, mLorenzParams ) ) {
+        return;
+    }
+    vector<Vec3f> initConditions( mEnsembleSize );
+    for( int32_t k=0; k<mEnsembleSize; k++ ) {
+        initConditions[k] = mLorenzParams.mInitialCondition + Vec3f( k * mEnsembleSpread, 0.0f, 0.0f );
+    }
+    Timer solveTimer( true );
+    mSolver.solveEnsemble( initConditions, mEnsembleSolutions );
+    mQuality.addSolveTime( solveTimer.getSeconds() );
+    mEnsembleMesh.updatePositions( mEnsembleSolutions, mEnsembleSize );
+    mEnsembleParams = mLorenzParams;
+    mEnsembleSolvedSize = mEnsembleSize;
+    mEnsembleSolvedSpread = mEnsembleSpread;
+    mEnsembleStride = stride;
 }
 
 
@@ -258,6 +1006,7 @@ void LAxApp::initModel ()
 void LAxApp::resize()
 {
     App::resize();
+    if( mBatchRun ) return;     // no camera set up
     updateCameraPerspective();
 }
 
@@ -283,7 +1032,11 @@ void LAxApp::update()
     static const size_t ssdSize = 10;
     static std::deque<Vec3f> ssdq;
 
+    if( mBatchRun ) return;     // quitting
+
     mAverageFps = getAverageFps();
+    mQuality.beginFrame( getElapsedSeconds() );
+    applyQuality();
     if( mLorenzParams.mAutoIncementX ) {
         mLorenzParams.mInitialCondition.x += 0.001f;
     }
@@ -297,23 +1050,46 @@ void LAxApp::update()
         //mSolver.updateInitialCondition(0.0001f, 0.0f, 0.0f);
         //console() << "Updating the model..." << endl;
         //mNeed2updateModel = false;
-        mSolver.useRK4( mLorenzParams.mUseRK4 );
-        mSolver.setParameters( mLorenzParams.mParam_S, mLorenzParams.mParam_R, mLorenzParams.mParam_B );
+        mSolver.setIntegrator( LorenzSolver::Integrator( mLorenzParams.mIntegrator ) );
+        mSolver.setTaylorOrder( mLorenzParams.mTaylorOrder );
+        mSolver.setTaylorTolerance( pow( 10.0, mLorenzParams.mTaylorToleranceExp ) );
+        if( mLorenzParams.mSystem != mShownSystem ) {
+            // another system: start from a point near its attractor
+            mLorenzParams.mInitialCondition = getAttractorInfo( AttractorSystem( mLorenzParams.mSystem ) ).mInitialCondition;
+            showSystemParams();
+        }
+        const AttractorSystem system = AttractorSystem( mLorenzParams.mSystem );
+        mSolver.setSystem( system, mLorenzParams.mSystemParams[system] );
         mSolver.setInitialConditions( mLorenzParams.mInitialCondition );
-        mSolver.solve();
-        vector<ci::Vec3f>& positions = mSolver.getSolutions();
-        mCenterPos = mSolver.getCenterPos();
-        Color clr = Color::black();
-        gl::VboMesh::VertexIter vertexIter = mModelMesh.mapVertexBuffer();
-        auto e = positions.begin();
-        for( uint32_t i=0; e != positions.end(); ++e, i++ ) {
-            // color by iteration count; starting blue, each following solution gets warmer.
-            clr.r = float(i)/float(MAX_STEPS);
-            clr.b = 1.0f - clr.r;
-            clr.g = 0.33f; 
-            // update the VBO positions and colors
-            mSphereModel.updateVBO( vertexIter, *e, clr);
+        // the curvature tolerance is in pixels at the model center
+        float pixelSize = 2.0f * mCamEyePoint.distance( mCamTarget ) * tan( toRadians( mCamFovAngle ) * 0.5f ) / float( getWindowHeight() );
+        float refinement = float( 1 << ( mQualityMaxRefinement - mQuality.getValue( QUALITY_REFINEMENT ) ) );
+        mSolver.setSampling( LorenzSolver::Sampling( mSampling ), mSampleSpacing * refinement, mSampleTolerance * pixelSize * refinement );
+        int32_t stride = mQuality.getValue( QUALITY_STRIDE );
+        mSolver.setIntegrationStep( getAttractorInfo( system ).mH / float(stride), stride );
+        // the ensemble's first trajectory is the single one; no need to solve it again
+        if( ! mEnsembleMode ) {
+            Timer solveTimer( true );
+            mSolver.solve();
+            mQuality.addSolveTime( solveTimer.getSeconds() );
         }
+        // with adaptive sampling the spheres are drawn at the samples only
+        bool adaptive = mSolver.getSampling() != LorenzSolver::SAMPLING_STRIDE;
+        vector<ci::Vec3f>& spheres = adaptive ? mSolver.getSamples() : mSolver.getSolutions();
+        const vector<uint32_t>& steps = mSolver.getSampleSteps();
+        if( mEnsembleMode ) {
+            updateEnsemble();
+        } else if( mRenderMode == RENDER_TUBE ) {
+            updateTube( spheres, steps );
+        } else if( mRenderMode == RENDER_POINTS ) {
+            updatePointCloud();
+        } else if( mVertexFormat != VERTEX_FORMAT_FLOAT ) {
+            updatePackedMesh( spheres, steps );
+        } else {
+            updateSpheres( spheres, adaptive ? steps : vector<uint32_t>() );
+        }
+        mCenterPos = mSolver.getCenterPos();
+        const Vec3f *positions = mEnsembleMode ? &mEnsembleSolutions[0] : &mSolver.getSolutions()[0];
         ssdq.push_back( positions[mLorenzParams.mNumSteps-1] );
         if( ssdq.size() > ssdSize ) {
             ssdq.pop_front();
@@ -356,6 +1132,41 @@ void LAxApp::update()
 ** The actual rendering... Called once per each frame after update().
 */
 void LAxApp::draw()
+{
+    if( mBatchRun ) return;     // quitting
+    if( mFrameCapture.isCapturing() && mCaptureFbo ) {
+        // Offline capture: render into the FBO and only show a preview of it
+        mCaptureFbo.bindFramebuffer();
+        gl::setViewport( mCaptureFbo.getBounds() );
+        drawScene();
+        mFrameCapture.captureFrame();
+        mCaptureFbo.unbindFramebuffer();
+        gl::setViewport( getWindowBounds() );
+        gl::clear( Color::black() );
+        glDisable( GL_LIGHTING );
+        gl::setMatricesWindow( getWindowSize() );
+        gl::color( Color::white() );
+        gl::draw( mCaptureFbo.getTexture(), getWindowBounds() );
+        gl::setMatrices( mCam );
+    } else {
+        drawScene();
+        if( mFrameCapture.isCapturing() ) {
+            mFrameCapture.captureFrame();   // before the params panel, so it is not recorded
+        }
+    }
+    mParams->draw();
+    mQuality.endFrame( getElapsedSeconds() );
+
+    if( mCaptureFrameLimit > 0 && mFrameCapture.getFramesCaptured() >= (size_t)mCaptureFrameLimit ) {
+        stopCapture();
+    }
+}
+
+
+/*
+** Render the model, on screen or into the capture FBO.
+*/
+void LAxApp::drawScene()
 {
     // Render the model................................
     gl::clear( Color( 0.0f, 0.05f, 0.1f ) );
@@ -364,17 +1175,41 @@ void LAxApp::draw()
     gl::pushMatrices();
         if( mViewModelEnabled ) {
             gl::translate( -mCenterPos );
-            if( mModelMesh ) {
+            if( mEnsembleMode && mEnsembleMesh.isInitialized() ) {
+                int32_t numSteps = min( mIterativeDraw ? mIterationCnt : mLorenzParams.mNumSteps, mQuality.getValue( QUALITY_STEPS ) );
+                for( int32_t k=0; k<mEnsembleSize; k++ ) {
+                    mEnsembleMesh.setDrawRange( k, 0, numSteps );
+                }
+                mEnsembleMesh.draw();
+            } else if( mRenderMode == RENDER_POINTS && mPointCloud.isInitialized() ) {
+                // iterative draw: the same part of the trajectory as with the spheres
+                size_t numPoints = mPointCloud.getNumPoints();
                 if( mIterativeDraw ) {
-                    drawRange( mModelMesh, 0, mIterationCnt * mIndicesPerSphere);
+                    // in 64 bits: millions of points times thousands of steps overflow size_t on Win32
+                    numPoints = size_t( uint64_t( numPoints ) * mIterationCnt / max( mLorenzParams.mNumSteps, 1 ) );
+                }
+                mPointCloud.draw( numPoints, mCamFovAngle, getWindowHeight() );
+                mNumSpheresDrawn = int32_t( numPoints );
+                mNumTrianglesDrawn = 0;
+            } else if( mModelMesh || mPackedMesh.isInitialized() ) {
+                int32_t numSteps = mIterativeDraw ? mIterationCnt : mLorenzParams.mNumSteps;
+                numSteps = min( numSteps, mQuality.getValue( QUALITY_STEPS ) );
+                if( mSolver.getSampling() != LorenzSolver::SAMPLING_STRIDE ) {
+                    mNumSpheresDrawn = int32_t( mSolver.getNumSamples( numSteps ) );
                 } else {
-                    drawRange( mModelMesh, 0, mLorenzParams.mNumSteps * mIndicesPerSphere);
-                    //gl::draw( mModelMesh );
+                    mNumSpheresDrawn = min( numSteps, mModelNumElements );
                 }
+                if( mRenderMode == RENDER_TUBE && mTubeMesh.isInitialized() ) {
+                    mTubeMesh.draw( mNumSpheresDrawn );
+                    mNumTrianglesDrawn = int32_t( mTubeMesh.getNumTriangles( mNumSpheresDrawn ) );
+                } else {
+                    drawSpheres( mNumSpheresDrawn );
+                    mNumTrianglesDrawn = mNumSpheresDrawn * ( mModelMesh ? mSphereLodCounts[mSphereLod] : mIndicesPerSphere ) / 3;
+                }
+                //gl::draw( mModelMesh );
             }
         }
     gl::popMatrices();
-    mParams->draw();
 }
 
 
@@ -9,6 +9,9 @@
 */
 
 #include <vector>
+#include <algorithm>
+#include <math.h>
+#include <ppl.h>
 
 #include "cinder/Cinder.h"
 #include "cinder/Vector.h"
@@ -22,7 +25,12 @@ using namespace ci;
 //
 void LorenzSolver::initOnce()
 {
-    mUseRK4 = true;
+    mIntegrator = INTEGRATOR_RK4;
+    mTaylorOrder = DEFAULT_TAYLOR_ORDER;
+    mTaylorTolerance = DEFAULT_TAYLOR_TOLERANCE;
+    mSampling = SAMPLING_STRIDE;
+    mSampleSpacing = DEFAULT_SAMPLE_SPACING;
+    mSampleTolerance = 0.0f;
     mInitCondition = mOriginalInitCondition;
     mSolutions = std::vector<Vec3f>();
     mSolutions.reserve( mNumPositions );
@@ -30,6 +38,32 @@ void LorenzSolver::initOnce()
     mMinPos = Vec3f( FLT_MAX, FLT_MAX, FLT_MAX );
     mCenterPos = Vec3f::zero();
     mIsCenterCalculated = false;
+    mRhsEvaluations = 0;
+}
+
+
+void LorenzSolver::setParameters( float s, float r, float b )
+{
+    const float params[ATTRACTOR_MAX_PARAMS] = { s, r, b };
+    setSystem( ATTRACTOR_LORENZ, params );
+}
+
+
+// Switch the system (and its parameters). The model center is found 
+// again for the new system, by the next solve().
+//
+void LorenzSolver::setSystem( AttractorSystem system, const float *params )
+{
+    const AttractorInfo &info = getAttractorInfo( system );
+    for( size_t i = 0; i < ATTRACTOR_MAX_PARAMS; i++ ) {
+        mParams[i] = ( i < info.mNumParams ) ? params[i] : 0.0f;
+    }
+    if( system != mSystem ) {
+        mSystem = system;
+        mMaxPos = Vec3f( FLT_MIN, FLT_MIN, FLT_MIN );
+        mMinPos = Vec3f( FLT_MAX, FLT_MAX, FLT_MAX );
+        mIsCenterCalculated = false;
+    }
 }
 
 
@@ -37,46 +71,307 @@ void LorenzSolver::initOnce()
 //
 void LorenzSolver::solve()
 {
-    mSolutions.clear();
-    mU0 = mInitCondition;
-    mSolutions.push_back(mU0);
-    for (size_t i = 1; i < mStride*mNumPositions; i++) {
-        nextStep( mU0, mU1 );
-        mU0 = mU1;
-        if( i%mStride==0 ) {
-            mSolutions.push_back( Vec3f(mU1) );
-            if( ! mIsCenterCalculated) { trackBounds( mU1 ); }
+    mSolutions.resize( mNumPositions );
+    if( isTaylor() ) {
+        mRhsEvaluations = solveTaylor( mInitCondition, &mSolutions[0], mNumPositions );
+    } else {
+        integrate( mInitCondition, &mSolutions[0], mNumPositions );
+        mRhsEvaluations = mStride * (mNumPositions - 1) * (mIntegrator == INTEGRATOR_RK4 ? 4 : 1);
+    }
+    for( size_t i = 1; i < mNumPositions && ! mIsCenterCalculated; i++ ) {
+        trackBounds( mSolutions[i] );
+    }
+    resample();
+}
+
+
+// Pick the adaptive samples from the solutions, in one pass (see the
+// header). For the curvature criterion the deviation from the chord is
+// estimated from the arc length L and the total turning angle a since
+// the last sample: a circular arc deviates by L*a/8, so L*a/4 leaves 
+// room for paths that do not turn evenly.
+//
+void LorenzSolver::resample()
+{
+    mSamples.clear();
+    mSampleSteps.clear();
+    if( mSampling == SAMPLING_STRIDE || mSolutions.empty() ) return;
+
+    mSamples.push_back( mSolutions[0] );
+    mSampleSteps.push_back( 0 );
+    float arc = 0.0f, turn = 0.0f;
+    Vec3f lastDir = Vec3f::zero();
+    for( size_t i = 1; i < mSolutions.size(); i++ ) {
+        Vec3f d = mSolutions[i] - mSolutions[i-1];
+        float len = d.length();
+        if( len <= 0.0f ) continue;
+        d /= len;
+        // the turn across a sample counts towards the next one
+        if( lastDir != Vec3f::zero() ) {
+            float c = lastDir.dot( d );
+            turn += acosf( c > 1.0f ? 1.0f : ( c < -1.0f ? -1.0f : c ) );
+        }
+        lastDir = d;
+        arc += len;
+        bool emit;
+        if( mSampling == SAMPLING_CURVATURE ) {
+            emit = arc >= mSampleSpacing * CURVATURE_MAX_SPACING || arc * turn * 0.25f >= mSampleTolerance;
+        } else {
+            emit = arc >= mSampleSpacing;
+        }
+        if( emit ) {
+            mSamples.push_back( mSolutions[i] );
+            mSampleSteps.push_back( uint32_t(i) );
+            arc = turn = 0.0f;
         }
     }
+    // the trajectory ends where the solutions do
+    if( mSampleSteps.back() != mSolutions.size() - 1 ) {
+        mSamples.push_back( mSolutions.back() );
+        mSampleSteps.push_back( uint32_t( mSolutions.size() - 1 ) );
+    }
 }
 
 
-// Calculate one step
+// Number of adaptive samples taken from the first numSteps solutions
 //
-void LorenzSolver::nextStep( Vec3f& u_t0, Vec3f& u_t1 )
+size_t LorenzSolver::getNumSamples( size_t numSteps ) const
 {
-    mUseRK4 ? nextStepRK4( u_t0, u_t1 ) : nextStepEuler( u_t0, u_t1 );
+    return std::lower_bound( mSampleSteps.begin(), mSampleSteps.end(), uint32_t(numSteps) ) - mSampleSteps.begin();
+}
+
+
+// Calculate the solutions for a set of initial conditions at once.
+// The result is trajectory-major: solutions[k*numPositions + i] is step i
+// of trajectory k. The trajectories are independent of each other, so 
+// they are spread over the available cores. The model bounds (used for
+// the center) are taken from the first trajectory, as solve() would.
+//
+void LorenzSolver::solveEnsemble( const std::vector<Vec3f> &initConditions, std::vector<Vec3f> &solutions )
+{
+    size_t numTrajectories = initConditions.size();
+    solutions.resize( numTrajectories * mNumPositions );
+    concurrency::parallel_for( size_t(0), numTrajectories, [&]( size_t k ) {
+        Vec3f *out = &solutions[k * mNumPositions];
+        if( isTaylor() ) {
+            solveTaylor( initConditions[k], out, mNumPositions );
+        } else {
+            integrate( initConditions[k], out, mNumPositions );
+        }
+    });
+    for( size_t i = 1; i < mNumPositions && numTrajectories > 0 && ! mIsCenterCalculated; i++ ) {
+        trackBounds( solutions[i] );
+    }
+}
+
+
+// Calculate numPositions solutions from the current initial condition
+// straight into the given buffer (e.g. a mapped VBO), independent of 
+// the solver's own size and solutions; for very long trajectories.
+//
+void LorenzSolver::solve( Vec3f *solutions, size_t numPositions )
+{
+    if( numPositions == 0 ) return;
+    if( isTaylor() ) {
+        solveTaylor( mInitCondition, solutions, numPositions );
+    } else {
+        integrate( mInitCondition, solutions, numPositions );
+    }
+}
+
+
+// Advance u by numSteps steps of the fixed step integrator, keeping no 
+// solutions. Like solveEnsemble(), it does not change the solver, so it 
+// may run on several threads at once (PararealSolver does).
+//
+void LorenzSolver::propagate( Vec3f &u, size_t numSteps )
+{
+    advance( u, numSteps );
+}
+
+
+// The same in double precision: with a very small H the float state 
+// would lose most of each step to rounding.
+//
+void LorenzSolver::propagate( Vec3d &u, size_t numSteps )
+{
+    advance( u, numSteps );
 }
 
 
 // Euler integration step
 //
-void LorenzSolver::nextStepEuler( Vec3f& u_t0, Vec3f& u_t1 )
+template<class System, typename T> static inline Vec3<T> stepEuler( const System &f, const Vec3<T> &u, T h )
 {
-    u_t1 = u_t0 + mH * LorenzEquations( u_t0 );
+    return u + h * f( u );
 }
 
 
 // 4th order Runge-Kutta (RK4) integration step
 //
-void LorenzSolver::nextStepRK4( Vec3f& u_t0, Vec3f& u_t1 )
+template<class System, typename T> static inline Vec3<T> stepRK4( const System &f, const Vec3<T> &u, T h )
+{
+    Vec3<T> k1, k2, k3, k4;
+    k1 = f( u );
+    k2 = f( u + T(0.5)*h*k1 );
+    k3 = f( u + T(0.5)*h*k2 );
+    k4 = f( u + h*k3 );
+    return u + (h/T(6))*( k1 + 2*k2 + 2*k3 + k4 );
+}
+
+
+// The fixed step kernels, one instance per system: numPositions 
+// solutions from u, one every mStride steps; or numSteps steps of u.
+//
+template<class System> void LorenzSolver::integrateWith( const System &f, Vec3f u, Vec3f *solutions, size_t numPositions ) const
+{
+    const float h = mH;
+    *solutions++ = u;
+    if( mIntegrator == INTEGRATOR_EULER ) {
+        for( size_t i = 1; i < numPositions; i++ ) {
+            for( size_t j = 0; j < mStride; j++ ) {
+                u = stepEuler( f, u, h );
+            }
+            *solutions++ = u;
+        }
+    } else {
+        for( size_t i = 1; i < numPositions; i++ ) {
+            for( size_t j = 0; j < mStride; j++ ) {
+                u = stepRK4( f, u, h );
+            }
+            *solutions++ = u;
+        }
+    }
+}
+
+
+template<class System, typename T> void LorenzSolver::advanceWith( const System &f, Vec3<T> &u, size_t numSteps ) const
+{
+    const T h = mH;
+    if( mIntegrator == INTEGRATOR_EULER ) {
+        for( size_t i = 0; i < numSteps; i++ ) {
+            u = stepEuler( f, u, h );
+        }
+    } else {
+        for( size_t i = 0; i < numSteps; i++ ) {
+            u = stepRK4( f, u, h );
+        }
+    }
+}
+
+
+// Pick the kernel of the current system, once per trajectory
+//
+void LorenzSolver::integrate( Vec3f u, Vec3f *solutions, size_t numPositions ) const
 {
-    Vec3f k1, k2, k3, k4;
-    k1 = LorenzEquations( u_t0 );
-    k2 = LorenzEquations( u_t0 + 0.5f*mH*k1 );
-    k3 = LorenzEquations( u_t0 + 0.5f*mH*k2 );
-    k4 = LorenzEquations( u_t0 + mH*k3 );
-    u_t1 = u_t0 + (mH/6.0f)*( k1 + 2*k2 + 2*k3 + k4 );
+    switch( mSystem ) {
+        case ATTRACTOR_ROSSLER:   integrateWith( RosslerSystem( mParams ), u, solutions, numPositions ); break;
+        case ATTRACTOR_CHEN:      integrateWith( ChenSystem( mParams ), u, solutions, numPositions ); break;
+        case ATTRACTOR_THOMAS:    integrateWith( ThomasSystem( mParams ), u, solutions, numPositions ); break;
+        case ATTRACTOR_HALVORSEN: integrateWith( HalvorsenSystem( mParams ), u, solutions, numPositions ); break;
+        default:                  integrateWith( LorenzSystem( mParams ), u, solutions, numPositions ); break;
+    }
+}
+
+
+template<typename T> void LorenzSolver::advance( Vec3<T> &u, size_t numSteps ) const
+{
+    switch( mSystem ) {
+        case ATTRACTOR_ROSSLER:   advanceWith( RosslerSystem( mParams ), u, numSteps ); break;
+        case ATTRACTOR_CHEN:      advanceWith( ChenSystem( mParams ), u, numSteps ); break;
+        case ATTRACTOR_THOMAS:    advanceWith( ThomasSystem( mParams ), u, numSteps ); break;
+        case ATTRACTOR_HALVORSEN: advanceWith( HalvorsenSystem( mParams ), u, numSteps ); break;
+        default:                  advanceWith( LorenzSystem( mParams ), u, numSteps ); break;
+    }
+}
+
+
+// Taylor-series integration, in double precision.
+//
+// The Lorenz equations are quadratic, so the Taylor coefficients of the
+// solution around u(t) follow from a simple recurrence (u[k] is the k'th
+// coefficient, (a*b)[k] the Cauchy product sum over j of a[j]*b[k-j]):
+//
+//   x[k+1] = S*(y[k] - x[k]) / (k+1)
+//   y[k+1] = (R*x[k] - y[k] - (x*z)[k]) / (k+1)
+//   z[k+1] = ((x*y)[k] - B*z[k]) / (k+1)
+//
+// The step size is chosen so that the last two terms of the series are
+// below the tolerance; the samples that fall inside a step are evaluated 
+// from the series directly (dense output), so they come at exactly the 
+// same times as with the fixed step integrators.
+// Returns the work in RK4 RHS evaluations, for comparing with the fixed
+// step integrators: the multiplies of the series (order k costs 2(k+1)
+// for the Cauchy products and 6 more; each evaluation of the series, for
+// the next step or a sample, 3 per order) over TAYLOR_MULTIPLIES_PER_RHS.
+//
+size_t LorenzSolver::solveTaylor( const Vec3f& initCondition, Vec3f *solutions, size_t numPositions )
+{
+    const int p = mTaylorOrder;
+    const double S = mParams[0], R = mParams[1], B = mParams[2];
+    const double dtOut = double(mH) * double(mStride);
+    double x[TAYLOR_MAX_ORDER+1], y[TAYLOR_MAX_ORDER+1], z[TAYLOR_MAX_ORDER+1];
+    double t = 0.0;
+    size_t multiplies = 0;
+
+    x[0] = initCondition.x;
+    y[0] = initCondition.y;
+    z[0] = initCondition.z;
+    solutions[0] = initCondition;
+    size_t next = 1;
+    while( next < numPositions ) {
+        for( int k = 0; k < p; k++ ) {
+            double xz = 0.0, xy = 0.0;
+            for( int j = 0; j <= k; j++ ) {
+                xz += x[j] * z[k-j];
+                xy += x[j] * y[k-j];
+            }
+            double inv = 1.0 / (k + 1);
+            x[k+1] = S * (y[k] - x[k]) * inv;
+            y[k+1] = (R * x[k] - y[k] - xz) * inv;
+            z[k+1] = (xy - B * z[k]) * inv;
+        }
+        multiplies += p*(p+1) + 6*p + 3*p;   // the series, then stepping to its end
+
+        double scale = std::max( 1.0, std::max( fabs(x[0]), std::max( fabs(y[0]), fabs(z[0]) ) ) );
+        double tol = mTaylorTolerance * scale;
+        double normP1 = std::max( fabs(x[p-1]), std::max( fabs(y[p-1]), fabs(z[p-1]) ) );
+        double normP  = std::max( fabs(x[p]),   std::max( fabs(y[p]),   fabs(z[p]) ) );
+        double h = TAYLOR_MAX_STEP;
+        if( normP1 > 0.0 ) h = std::min( h, pow( tol / normP1, 1.0 / (p-1) ) );
+        if( normP > 0.0 )  h = std::min( h, pow( tol / normP, 1.0 / p ) );
+        if( ! (h > 1.0e-12) ) {
+            // unbounded solution (NaN or overflow): no way to go on
+            for( ; next < numPositions; next++ ) {
+                solutions[next] = solutions[next-1];
+            }
+            break;
+        }
+
+        // samples inside [t, t+h], then the start of the next step (Horner)
+        while( next < numPositions && next*dtOut <= t + h ) {
+            double tau = next*dtOut - t;
+            double sx = x[p], sy = y[p], sz = z[p];
+            for( int k = p-1; k >= 0; k-- ) {
+                sx = sx*tau + x[k];
+                sy = sy*tau + y[k];
+                sz = sz*tau + z[k];
+            }
+            solutions[next++] = Vec3f( float(sx), float(sy), float(sz) );
+            multiplies += 3*p;
+        }
+        double sx = x[p], sy = y[p], sz = z[p];
+        for( int k = p-1; k >= 0; k-- ) {
+            sx = sx*h + x[k];
+            sy = sy*h + y[k];
+            sz = sz*h + z[k];
+        }
+        x[0] = sx;
+        y[0] = sy;
+        z[0] = sz;
+        t += h;
+    }
+    return ( multiplies + TAYLOR_MULTIPLIES_PER_RHS / 2 ) / TAYLOR_MULTIPLIES_PER_RHS;
 }
 
 
@@ -107,19 +402,3 @@ Vec3f LorenzSolver::getCenterPos()
     }
     return mCenterPos;
 }
-
-
-/////////////////////////////////////////
-//
-// Finally, the actual Lorenz equations:
-//
-Vec3f  LorenzSolver::LorenzEquations( Vec3f u )
-{
-  Vec3f dUdT;
-  dUdT.x = mS * (u.y - u.x);
-  dUdT.y = -u.x * u.z + mR * u.x - u.y;
-  dUdT.z = u.x * u.y - mB * u.z;
-  return dUdT;
-}
-//
-/////////////////////////////////////////
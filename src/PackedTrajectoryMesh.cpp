@@ -0,0 +1,278 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ Trajectory spheres in compact vertex formats; see PackedTrajectoryMesh.h.
+*/
+
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Vbo.h"
+#include "cinder/Color.h"
+#include "cinder/Vector.h"
+#include <vector>
+#include <algorithm>
+#include <stddef.h>
+#include <math.h>
+
+#include "PackedTrajectoryMesh.h"
+#include "VertexPacking.h"
+#include "GlExtensions.h"
+
+using namespace ci;
+using namespace std;
+
+#define FLOAT_LAYOUT_BYTES          28  // per vertex, as in LAxApp::initSphereMesh(): position, normal, RGBA8 color
+#define FLOAT_LAYOUT_DYNAMIC_BYTES  12  // ...of which written per moved sphere vertex: the position
+
+
+namespace {
+
+    struct HalfPosition {
+        uint16_t    mPosition[4];   // x, y, z and padding
+    };
+
+}
+
+
+// The format init() builds for the requested one; callers compare with
+// getFormat() through this, so a fallback does not look like a change.
+//
+PackedTrajectoryMesh::PositionFormat PackedTrajectoryMesh::getSupportedFormat( PositionFormat format )
+{
+    return ( format == POSITION_HALF && ! glext::hasHalfFloatVertex() ) ? POSITION_FLOAT : format;
+}
+
+
+void PackedTrajectoryMesh::init( size_t numSpheres, const SphereMeshModel &sphereModel, PositionFormat format )
+{
+    mNumSpheres = numSpheres;
+    mFormat = getSupportedFormat( format );
+    mNormalType = glext::hasVertexType2_10_10_10_Rev() ? GL_INT_2_10_10_10_REV : GL_BYTE;
+    mVerticesPerSphere = sphereModel.getNumVertices();
+    mIndicesPerSphere = sphereModel.getNumIndices();
+    assert( PACKED_CHUNK_SPHERES * mVerticesPerSphere <= 0x10000 );
+
+    mSpherePositions.resize( mVerticesPerSphere );
+    sphereModel.updatePositions( &mSpherePositions[0], Vec3f::zero() );
+    mSphereNormals.clear();
+    sphereModel.getStaticNormals( mSphereNormals );
+
+    // One chunk of spheres' worth of 16-bit indices, shared by all chunks
+    vector<uint16_t> sphereIndices;
+    sphereModel.getStaticIndices( sphereIndices );
+    vector<uint16_t> chunkIndices;
+    chunkIndices.reserve( PACKED_CHUNK_SPHERES * sphereIndices.size() );
+    for( uint32_t c=0; c<PACKED_CHUNK_SPHERES; c++ ) {
+        for( size_t j=0; j<sphereIndices.size(); j++ ) {
+            chunkIndices.push_back( uint16_t( c * mVerticesPerSphere + sphereIndices[j] ) );
+        }
+    }
+    mIndexVbo = gl::Vbo( GL_ELEMENT_ARRAY_BUFFER );
+    mIndexVbo.bufferData( chunkIndices.size() * sizeof(uint16_t), &chunkIndices[0], GL_STATIC_DRAW );
+    mIndexVbo.unbind();
+
+    // The static buffer: all the normals, then all the colors (white until set)
+    size_t nVertices = mNumSpheres * mVerticesPerSphere;
+    vector<uint32_t> normals( nVertices );
+    for( size_t i=0; i<nVertices; i++ ) {
+        normals[i] = packNormal( mSphereNormals[i % mVerticesPerSphere] );
+    }
+    vector<ColorA8u> colors( nVertices, ColorA8u( 255, 255, 255, 255 ) );
+    mColorOffset = nVertices * sizeof(uint32_t);
+    mStaticVbo = gl::Vbo( GL_ARRAY_BUFFER );
+    mStaticVbo.bufferData( mColorOffset + nVertices * sizeof(ColorA8u), NULL, GL_STATIC_DRAW );
+    mStaticVbo.bufferSubData( 0, mColorOffset, &normals[0] );
+    mStaticVbo.bufferSubData( mColorOffset, nVertices * sizeof(ColorA8u), &colors[0] );
+    mStaticVbo.unbind();
+
+    // The dynamic buffer: the positions, written where the spheres move
+    mDynamicStride = ( mFormat == POSITION_HALF ) ? sizeof(HalfPosition) : sizeof(Vec3f);
+    mDynamicVbo = gl::Vbo( GL_ARRAY_BUFFER );
+    mDynamicVbo.bufferData( nVertices * mDynamicStride, NULL, GL_DYNAMIC_DRAW );
+    mDynamicVbo.unbind();
+
+    mChunkOrigins.assign( (mNumSpheres + PACKED_CHUNK_SPHERES - 1) / PACKED_CHUNK_SPHERES, Vec3f::zero() );
+    mHeldCenters.clear();
+    mColors.assign( mNumSpheres, Colorf::white() );
+    mPackedColors.assign( mNumSpheres, ColorA8u( 255, 255, 255, 255 ) );
+    mUploadBytes = 0;
+}
+
+
+// Set the sphere colors; only the range of spheres whose RGBA8 color
+// changed is written to the static buffer.
+//
+void PackedTrajectoryMesh::setSphereColors( const vector<Colorf> &colors )
+{
+    size_t n = min( mNumSpheres, colors.size() );
+    size_t first = n, last = 0;
+    for( size_t i=0; i<n; i++ ) {
+        mColors[i] = colors[i];
+        ColorA8u packed( packUnorm8(colors[i].r), packUnorm8(colors[i].g), packUnorm8(colors[i].b), 255 );
+        if( packed.r != mPackedColors[i].r || packed.g != mPackedColors[i].g || packed.b != mPackedColors[i].b ) {
+            mPackedColors[i] = packed;
+            first = min( first, i );
+            last = i + 1;
+        }
+    }
+    if( first >= last ) return;
+    vector<ColorA8u> staging( ( last - first ) * mVerticesPerSphere );
+    for( size_t i=first; i<last; i++ ) {
+        fill_n( &staging[( i - first ) * mVerticesPerSphere], mVerticesPerSphere, mPackedColors[i] );
+    }
+    mStaticVbo.bufferSubData( mColorOffset + first * mVerticesPerSphere * sizeof(ColorA8u), staging.size() * sizeof(ColorA8u), &staging[0] );
+    mStaticVbo.unbind();
+    mUploadBytes += staging.size() * sizeof(ColorA8u);
+}
+
+
+// Write the positions of the spheres that moved since the last update,
+// as one range. With half floats each chunk takes its first sphere 
+// center as origin; when that one moves, the whole chunk is written.
+//
+void PackedTrajectoryMesh::update( const vector<Vec3f> &centers )
+{
+    const size_t n = min( mNumSpheres, centers.size() );
+    size_t first = n, last = 0;
+    for( size_t i=0; i<n; i++ ) {
+        if( i < mHeldCenters.size() && centers[i] == mHeldCenters[i] ) continue;
+        first = min( first, i );
+        last = max( last, i + 1 );
+        if( mFormat == POSITION_HALF && i % PACKED_CHUNK_SPHERES == 0 ) {
+            last = max( last, min( n, i + PACKED_CHUNK_SPHERES ) );
+        }
+    }
+    if( first >= last ) return;
+    if( mHeldCenters.size() < n ) {
+        mHeldCenters.resize( n );
+    }
+    mStaging.resize( ( last - first ) * mVerticesPerSphere * mDynamicStride );
+    uint8_t *dst = &mStaging[0];
+    for( size_t i=first; i<last; i++ ) {
+        size_t chunk = i / PACKED_CHUNK_SPHERES;
+        if( i % PACKED_CHUNK_SPHERES == 0 ) {
+            mChunkOrigins[chunk] = ( mFormat == POSITION_HALF ) ? centers[i] : Vec3f::zero();
+        }
+        Vec3f center = centers[i] - mChunkOrigins[chunk];
+        for( uint32_t v=0; v<mVerticesPerSphere; v++ ) {
+            Vec3f p = center + mSpherePositions[v];
+            if( mFormat == POSITION_HALF ) {
+                HalfPosition *hp = reinterpret_cast<HalfPosition*>( dst );
+                hp->mPosition[0] = packHalf( p.x );
+                hp->mPosition[1] = packHalf( p.y );
+                hp->mPosition[2] = packHalf( p.z );
+                hp->mPosition[3] = 0;
+            } else {
+                *reinterpret_cast<Vec3f*>( dst ) = p;
+            }
+            dst += mDynamicStride;
+        }
+        mHeldCenters[i] = centers[i];
+    }
+    mDynamicVbo.bufferSubData( first * mVerticesPerSphere * mDynamicStride, mStaging.size(), &mStaging[0] );
+    mDynamicVbo.unbind();
+    mUploadBytes += mStaging.size();
+}
+
+
+// One draw call per chunk; the arrays are pointed at the chunk's first
+// vertex so the chunk index list can be shared.
+//
+void PackedTrajectoryMesh::draw( size_t numSpheres )
+{
+    numSpheres = min( numSpheres, mNumSpheres );
+    if( numSpheres == 0 ) return;
+    GLenum positionType = ( mFormat == POSITION_HALF ) ? GL_HALF_FLOAT : GL_FLOAT;
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_NORMAL_ARRAY );
+    glEnableClientState( GL_COLOR_ARRAY );
+    mIndexVbo.bind();
+    for( size_t first=0, chunk=0; first<numSpheres; first += PACKED_CHUNK_SPHERES, chunk++ ) {
+        size_t n = min( size_t(PACKED_CHUNK_SPHERES), numSpheres - first );
+        size_t baseVertex = first * mVerticesPerSphere;
+        mStaticVbo.bind();
+        glNormalPointer( mNormalType, sizeof(uint32_t), (const GLvoid*)( baseVertex * sizeof(uint32_t) ) );
+        glColorPointer( 4, GL_UNSIGNED_BYTE, sizeof(ColorA8u), (const GLvoid*)( mColorOffset + baseVertex * sizeof(ColorA8u) ) );
+        mDynamicVbo.bind();
+        glVertexPointer( 3, positionType, GLsizei(mDynamicStride), (const GLvoid*)( baseVertex * mDynamicStride ) );
+        if( mFormat == POSITION_HALF ) {
+            gl::pushMatrices();
+            gl::translate( mChunkOrigins[chunk] );
+        }
+        glDrawElements( GL_TRIANGLES, GLsizei( n * mIndicesPerSphere ), GL_UNSIGNED_SHORT, 0 );
+        if( mFormat == POSITION_HALF ) {
+            gl::popMatrices();
+        }
+    }
+    mIndexVbo.unbind();
+    mDynamicVbo.unbind();
+    glDisableClientState( GL_VERTEX_ARRAY );
+    glDisableClientState( GL_NORMAL_ARRAY );
+    glDisableClientState( GL_COLOR_ARRAY );
+}
+
+
+uint32_t PackedTrajectoryMesh::packNormal( const Vec3f &n ) const
+{
+    return mNormalType == GL_INT_2_10_10_10_REV ? packSnorm10_10_10_2( n ) : packSnorm8( n );
+}
+
+
+Vec3f PackedTrajectoryMesh::unpackNormal( uint32_t packed ) const
+{
+    return mNormalType == GL_INT_2_10_10_10_REV ? unpackSnorm10_10_10_2( packed ) : unpackSnorm8( packed );
+}
+
+
+// Compare what the GPU gets from the compact layout with the float layout,
+// for the given sphere centers: position error in phase space units,
+// normal error in degrees, color error in fractions of full scale.
+//
+void PackedTrajectoryMesh::measurePrecision( const vector<Vec3f> &centers, std::ostream &out ) const
+{
+    size_t numSpheres = min( mNumSpheres, centers.size() );
+    double posMax = 0.0, posSumSq = 0.0;
+    size_t posCount = 0;
+    for( size_t i=0; i<numSpheres; i++ ) {
+        Vec3f origin = ( mFormat == POSITION_HALF ) ? centers[i - i % PACKED_CHUNK_SPHERES] : Vec3f::zero();
+        Vec3f center = centers[i] - origin;
+        for( uint32_t v=0; v<mVerticesPerSphere; v++ ) {
+            Vec3f exact = centers[i] + mSpherePositions[v];
+            Vec3f p = center + mSpherePositions[v];
+            if( mFormat == POSITION_HALF ) {
+                p = Vec3f( unpackHalf( packHalf(p.x) ), unpackHalf( packHalf(p.y) ), unpackHalf( packHalf(p.z) ) );
+            }
+            double err = (p + origin).distance( exact );
+            posMax = max( posMax, err );
+            posSumSq += err * err;
+            posCount++;
+        }
+    }
+    double normalMax = 0.0, normalSum = 0.0;
+    for( size_t v=0; v<mSphereNormals.size(); v++ ) {
+        Vec3f n = unpackNormal( packNormal( mSphereNormals[v] ) ).normalized();
+        float c = n.dot( mSphereNormals[v] );
+        double deg = acos( c > 1.0f ? 1.0f : c ) * 180.0 / 3.14159265358979;
+        normalMax = max( normalMax, deg );
+        normalSum += deg;
+    }
+    double colorMax = 0.0;
+    for( size_t i=0; i<mColors.size(); i++ ) {
+        colorMax = max( colorMax, (double) fabs( mColors[i].r - mPackedColors[i].r / 255.0f ) );
+        colorMax = max( colorMax, (double) fabs( mColors[i].g - mPackedColors[i].g / 255.0f ) );
+        colorMax = max( colorMax, (double) fabs( mColors[i].b - mPackedColors[i].b / 255.0f ) );
+    }
+
+    size_t sphereBytes = mVerticesPerSphere * mDynamicStride;
+    out << "Vertex format: " << ( mFormat == POSITION_HALF ? "half" : "float" ) << " positions, "
+        << ( mNormalType == GL_INT_2_10_10_10_REV ? "10:10:10:2" : "8-bit" ) << " normals, RGBA8 colors" << std::endl
+        << "  bytes per vertex:   " << getBytesPerVertex() << " (float layout " << FLOAT_LAYOUT_BYTES << ")" << std::endl
+        << "  written per moved sphere: " << sphereBytes << " (float layout " << mVerticesPerSphere * FLOAT_LAYOUT_DYNAMIC_BYTES << ")"
+        << ( mFormat == POSITION_HALF ? ", whole chunk when its first sphere moves" : "" ) << std::endl
+        << "  written by the last update: " << getUploadBytes() << " of " << getDynamicBytes() << std::endl
+        << "  position error:     max " << posMax << ", rms " << ( posCount ? sqrt( posSumSq / posCount ) : 0.0 ) << std::endl
+        << "  normal error (deg): max " << normalMax << ", mean " << ( mSphereNormals.empty() ? 0.0 : normalSum / mSphereNormals.size() ) << std::endl
+        << "  color error:        max " << colorMax << std::endl;
+}
@@ -0,0 +1,155 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ Parareal time-parallel integration; see PararealSolver.h.
+*/
+
+#include "cinder/Cinder.h"
+#include "cinder/Vector.h"
+#include "cinder/Timer.h"
+#include <vector>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+#include <thread>
+#include <math.h>
+#include <ppl.h>
+
+#include "PararealSolver.h"
+
+using namespace ci;
+using namespace std;
+
+
+PararealSolver::PararealSolver( float s, float r, float b ) :
+    mFine( 1, Vec3f::zero() ), mCoarse( 1, Vec3f::zero() ), mTolerance(PARAREAL_DEFAULT_TOLERANCE)
+{
+    mFine.setParameters( s, r, b );
+    mCoarse.setParameters( s, r, b );
+    setFine( LorenzSolver::INTEGRATOR_RK4, DEFAULT_H );
+    setCoarse( LorenzSolver::INTEGRATOR_RK4, PARAREAL_DEFAULT_COARSE_H );
+    mNumSlices = max( 1u, thread::hardware_concurrency() );
+}
+
+
+void PararealSolver::setFine( LorenzSolver::Integrator integrator, float h )
+{
+    mFine.setIntegrator( integrator );
+    mFine.setIntegrationStep( h );
+    mFineH = h;
+}
+
+
+void PararealSolver::setCoarse( LorenzSolver::Integrator integrator, float h )
+{
+    mCoarse.setIntegrator( integrator );
+    mCoarse.setIntegrationStep( h );
+    mCoarseH = h;
+}
+
+
+void PararealSolver::setSystem( AttractorSystem system, const float *params )
+{
+    mFine.setSystem( system, params );
+    mCoarse.setSystem( system, params );
+}
+
+
+// G: cover the slice's time span in whole coarse steps of about mCoarseH
+//
+void PararealSolver::coarse( Vec3d &u, size_t slice )
+{
+    double span = double(mSliceSteps[slice]) * mFineH;
+    size_t steps = max( size_t(1), size_t( span / mCoarseH + 0.5 ) );
+    mCoarse.setIntegrationStep( float( span / steps ) );
+    mCoarse.propagate( u, steps );
+}
+
+
+// Integrate numFineSteps fine steps from initCondition; boundaries gets
+// the state at the start of every slice and the final state.
+//
+PararealSolver::Result PararealSolver::run( const Vec3f &initCondition, size_t numFineSteps, vector<Vec3d> &boundaries )
+{
+    const size_t N = max( size_t(1), min( mNumSlices, numFineSteps ) );
+    mSliceSteps.assign( N, numFineSteps / N );
+    mSliceSteps[N-1] += numFineSteps % N;
+
+    Result result;
+    result.mSlices = N;
+    result.mIterations = 0;
+    result.mIsConverged = false;
+    Timer timer( true );
+
+    // Iteration 0: the coarse propagator alone
+    vector<Vec3d> &U = boundaries;
+    vector<Vec3d> G( N ), F( N );
+    U.resize( N+1 );
+    U[0] = Vec3d( initCondition );
+    for( size_t n=0; n<N; n++ ) {
+        G[n] = U[n];
+        coarse( G[n], n );
+        U[n+1] = G[n];
+    }
+
+    // Slices before k-1 are exact already and need no more fine runs
+    for( size_t k=1; k<=N && ! result.mIsConverged; k++ ) {
+        concurrency::parallel_for( k-1, N, [&]( size_t n ) {
+            F[n] = U[n];
+            mFine.propagate( F[n], mSliceSteps[n] );
+        });
+        double maxUpdate = 0.0;
+        for( size_t n=k-1; n<N; n++ ) {
+            Vec3d g = U[n];
+            coarse( g, n );
+            Vec3d u = g + F[n] - G[n];
+            G[n] = g;
+            maxUpdate = max( maxUpdate, u.distance( U[n+1] ) );
+            U[n+1] = u;
+        }
+        result.mUpdates.push_back( maxUpdate );
+        result.mIterations = k;
+        result.mIsConverged = maxUpdate < mTolerance;
+    }
+    result.mWallTime = timer.getSeconds();
+    return result;
+}
+
+
+// Parareal against the serial fine integration of the same steps:
+// wall times, speedup and how far the results are apart.
+//
+void PararealSolver::benchmark( const Vec3f &initCondition, size_t numFineSteps, ostream &out )
+{
+    vector<Vec3d> boundaries;
+    Result result = run( initCondition, numFineSteps, boundaries );
+
+    Timer timer( true );
+    Vec3d u( initCondition );
+    double maxDifference = 0.0;
+    for( size_t n=0; n<result.mSlices; n++ ) {
+        mFine.propagate( u, mSliceSteps[n] );
+        maxDifference = max( maxDifference, u.distance( boundaries[n+1] ) );
+    }
+    double serialTime = timer.getSeconds();
+
+    ios::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+    out << "Parareal: " << numFineSteps << " fine steps, H=" << mFineH << ", span " << numFineSteps * double(mFineH)
+        << ", " << result.mSlices << " slices, coarse H=" << mCoarseH << ", tolerance " << mTolerance << endl;
+    for( size_t k=0; k<result.mUpdates.size(); k++ ) {
+        out << "  iteration " << setw(3) << k+1 << ": max boundary update " << scientific << setprecision(3) << result.mUpdates[k] << endl;
+        out.unsetf( ios::floatfield );
+    }
+    out << ( result.mIsConverged ? "  converged after " : "  not converged after " ) << result.mIterations << " iterations" << endl;
+    out << fixed << setprecision(3)
+        << "  serial fine " << serialTime << " s, parareal " << result.mWallTime << " s, speedup " << serialTime / result.mWallTime
+        << " (at most " << double(result.mSlices) / result.mIterations << " with " << result.mIterations << " iterations)" << endl;
+    out.unsetf( ios::floatfield );
+    out << "  difference from serial fine: end " << scientific << setprecision(3) << u.distance( boundaries[result.mSlices] )
+        << ", max over the slice boundaries " << maxDifference << endl;
+    out.flags( flags );
+    out.precision( precision );
+}
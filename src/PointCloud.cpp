@@ -0,0 +1,147 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ Trajectory drawn as point sprites; see PointCloud.h.
+*/
+
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Vbo.h"
+#include "cinder/gl/Texture.h"
+#include "cinder/Surface.h"
+#include "cinder/Color.h"
+#include "cinder/Vector.h"
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "PointCloud.h"
+
+using namespace ci;
+using namespace std;
+
+
+void PointCloud::init( size_t maxPoints )
+{
+    mMaxPoints = maxPoints;
+    mNumPoints = 0;
+    mNumColors = 0;
+    mPositionVbo = gl::Vbo( GL_ARRAY_BUFFER );
+    mPositionVbo.bufferData( mMaxPoints * sizeof(Vec3f), NULL, GL_DYNAMIC_DRAW );
+    mColorVbo = gl::Vbo( GL_ARRAY_BUFFER );
+    mColorVbo.bufferData( mMaxPoints * sizeof(ColorA8u), NULL, GL_STATIC_DRAW );
+    mColorVbo.unbind();
+    buildSprite();
+}
+
+
+// Solve numPoints steps straight into the position buffer. The buffer
+// is orphaned first, so the map does not wait for the last frame's draw.
+//
+void PointCloud::update( LorenzSolver &solver, size_t numPoints )
+{
+    numPoints = min( numPoints, mMaxPoints );
+    if( numPoints != mNumColors ) {
+        buildColors( numPoints );
+    }
+    mPositionVbo.bufferData( mMaxPoints * sizeof(Vec3f), NULL, GL_DYNAMIC_DRAW );
+    Vec3f *positions = reinterpret_cast<Vec3f*>( mPositionVbo.map( GL_WRITE_ONLY ) );
+    if( positions != NULL ) {
+        solver.solve( positions, numPoints );
+        mPositionVbo.unmap();
+        mNumPoints = numPoints;
+    } else {
+        // the old points went with the orphaned storage
+        mNumPoints = 0;
+    }
+    mPositionVbo.unbind();
+}
+
+
+// Blue to red over the steps, green fixed, as the sphere view colors by step
+//
+void PointCloud::buildColors( size_t numPoints )
+{
+    vector<ColorA8u> colors( mMaxPoints );
+    for( size_t i=0; i<numPoints; i++ ) {
+        uint8_t r = uint8_t( 255.0f * float(i) / float(numPoints) );
+        colors[i] = ColorA8u( r, 84, 255 - r, 255 );
+    }
+    mColorVbo.bufferData( mMaxPoints * sizeof(ColorA8u), &colors[0], GL_STATIC_DRAW );
+    mColorVbo.unbind();
+    mNumColors = numPoints;
+}
+
+
+// The impostor: a unit sphere seen from the front, diffuse and specular
+// shading from a light up and to the left, white (colored per point by
+// GL_MODULATE), transparent outside the disc.
+//
+void PointCloud::buildSprite()
+{
+    const int32_t size = POINT_CLOUD_SPRITE_SIZE;
+    Surface8u sprite( size, size, true, SurfaceChannelOrder::RGBA );
+    Vec3f light = Vec3f( -0.4f, 0.5f, 0.77f ).normalized();
+    for( int32_t y=0; y<size; y++ ) {
+        uint8_t *row = sprite.getData( Vec2i( 0, y ) );
+        for( int32_t x=0; x<size; x++ ) {
+            float u = 2.0f * (x + 0.5f) / size - 1.0f;
+            float v = 1.0f - 2.0f * (y + 0.5f) / size;
+            float rr = u*u + v*v;
+            uint8_t *texel = row + 4*x;
+            if( rr > 1.0f ) {
+                texel[0] = texel[1] = texel[2] = texel[3] = 0;
+                continue;
+            }
+            Vec3f n( u, v, sqrt( 1.0f - rr ) );
+            float diffuse = max( 0.0f, n.dot( light ) );
+            float specular = pow( max( 0.0f, n.dot( ( light + Vec3f::zAxis() ).normalized() ) ), 40.0f );
+            float shade = min( 1.0f, 0.3f + 0.7f * diffuse + 0.4f * specular );
+            texel[0] = texel[1] = texel[2] = uint8_t( 255.0f * shade );
+            texel[3] = 255;
+        }
+    }
+    mSprite = gl::Texture( sprite );
+}
+
+
+// Draw the first numPoints points. The sprite size in pixels follows from
+// the projection: a sphere of mRadius at eye distance d covers
+// mRadius * viewportHeight / (d * tan(fov/2)) pixels, and GL divides the
+// point size by the square root of the quadratic attenuation, c*d^2.
+//
+void PointCloud::draw( size_t numPoints, float fovDegrees, int32_t viewportHeight )
+{
+    numPoints = min( numPoints, mNumPoints );
+    if( numPoints == 0 ) return;
+    float size = mRadius * viewportHeight / tan( toRadians( fovDegrees ) * 0.5f );
+    GLfloat attenuation[] = { 0.0f, 0.0f, 1.0f };
+
+    glPushAttrib( GL_ENABLE_BIT | GL_POINT_BIT | GL_TEXTURE_BIT | GL_COLOR_BUFFER_BIT );
+    glDisable( GL_LIGHTING );
+    glDisable( GL_BLEND );
+    glEnable( GL_ALPHA_TEST );
+    glAlphaFunc( GL_GREATER, 0.5f );
+    glEnable( GL_POINT_SPRITE );
+    glTexEnvi( GL_POINT_SPRITE, GL_COORD_REPLACE, GL_TRUE );
+    glPointParameterfv( GL_POINT_DISTANCE_ATTENUATION, attenuation );
+    glPointSize( size );
+    mSprite.enableAndBind();
+    glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
+
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_COLOR_ARRAY );
+    mPositionVbo.bind();
+    glVertexPointer( 3, GL_FLOAT, sizeof(Vec3f), 0 );
+    mColorVbo.bind();
+    glColorPointer( 4, GL_UNSIGNED_BYTE, sizeof(ColorA8u), 0 );
+    glDrawArrays( GL_POINTS, 0, GLsizei( numPoints ) );
+    mColorVbo.unbind();
+    glDisableClientState( GL_VERTEX_ARRAY );
+    glDisableClientState( GL_COLOR_ARRAY );
+
+    mSprite.unbind();
+    glPopAttrib();
+}
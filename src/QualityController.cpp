@@ -0,0 +1,150 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ Frame rate driven quality control; see QualityController.h.
+*/
+
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "QualityController.h"
+
+using namespace std;
+
+
+QualityController::QualityController() :
+    mIsEnabled(false), mTargetInterval(1.0/30.0), mFrameStart(-1.0), mLastFrameStart(-1.0), mFrameSolve(0.0),
+    mAvgInterval(0.0), mAvgBusy(0.0), mAvgSolve(0.0), mFramesSinceChange(0), mIdleFrames(0)
+{
+}
+
+
+size_t QualityController::addKnob( const string &name, Cost cost, int32_t minValue, int32_t maxValue, int32_t step )
+{
+    Knob knob;
+    knob.mName = name;
+    knob.mCost = cost;
+    knob.mMin = minValue;
+    knob.mMax = max( minValue, maxValue );
+    knob.mStep = step;
+    knob.mValue = knob.mMax;
+    mKnobs.push_back( knob );
+    return mKnobs.size() - 1;
+}
+
+
+// The user bounds may change at any time; the value is kept inside them
+//
+void QualityController::setBounds( size_t knob, int32_t minValue, int32_t maxValue )
+{
+    Knob &k = mKnobs[knob];
+    k.mMin = minValue;
+    k.mMax = max( minValue, maxValue );
+    k.mValue = max( k.mMin, min( k.mValue, k.mMax ) );
+}
+
+
+void QualityController::setEnabled( bool enabled )
+{
+    mIsEnabled = enabled;
+    if( ! mIsEnabled ) {
+        for( size_t i=0; i<mKnobs.size(); i++ ) {
+            mKnobs[i].mValue = mKnobs[i].mMax;
+        }
+        mLowered.clear();
+    }
+}
+
+
+void QualityController::beginFrame( double now )
+{
+    if( mFrameStart >= 0.0 ) {
+        mLastFrameStart = mFrameStart;
+    }
+    mFrameStart = now;
+    mFrameSolve = 0.0;
+}
+
+
+void QualityController::addSolveTime( double seconds )
+{
+    mFrameSolve += seconds;
+}
+
+
+// Update the averages and, when enabled and settled, change one knob
+//
+bool QualityController::endFrame( double now )
+{
+    if( mLastFrameStart < 0.0 ) return false;
+    double interval = mFrameStart - mLastFrameStart;
+    double busy = now - mFrameStart;
+    if( mAvgInterval == 0.0 ) {
+        mAvgInterval = interval;
+        mAvgBusy = busy;
+        mAvgSolve = mFrameSolve;
+    } else {
+        mAvgInterval += QUALITY_AVERAGING * ( interval - mAvgInterval );
+        mAvgBusy += QUALITY_AVERAGING * ( busy - mAvgBusy );
+        mAvgSolve += QUALITY_AVERAGING * ( mFrameSolve - mAvgSolve );
+    }
+    mFramesSinceChange++;
+    if( ! mIsEnabled || mFramesSinceChange < QUALITY_SETTLE_FRAMES ) return false;
+
+    bool changed = false;
+    if( mAvgInterval > mTargetInterval * QUALITY_SLOW_MARGIN ) {
+        mIdleFrames = 0;
+        changed = lower();
+    } else if( mAvgBusy < mTargetInterval * QUALITY_IDLE_MARGIN ) {
+        if( ++mIdleFrames >= QUALITY_IDLE_FRAMES ) {
+            mIdleFrames = 0;
+            changed = raise();
+        }
+    } else {
+        mIdleFrames = 0;
+    }
+    if( changed ) {
+        mFramesSinceChange = 0;
+    }
+    return changed;
+}
+
+
+// Lower the first knob (in the order added) that costs what takes most
+// of the frame, solve or render; any other knob if none of those can go lower.
+//
+bool QualityController::lower()
+{
+    Cost dominant = ( mAvgSolve > 0.5 * mAvgBusy ) ? COST_SOLVE : COST_RENDER;
+    for( int pass = 0; pass < 2; pass++ ) {
+        for( size_t i=0; i<mKnobs.size(); i++ ) {
+            Knob &k = mKnobs[i];
+            if( pass == 0 && ! ( k.mCost & dominant ) ) continue;
+            if( k.mValue > k.mMin ) {
+                k.mValue = max( k.mMin, k.mValue - k.mStep );
+                mLowered.push_back( i );
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+// Raise the knob lowered last; the ones the user has since capped are skipped
+//
+bool QualityController::raise()
+{
+    while( ! mLowered.empty() ) {
+        Knob &k = mKnobs[mLowered.back()];
+        mLowered.pop_back();
+        if( k.mValue < k.mMax ) {
+            k.mValue = min( k.mMax, k.mValue + k.mStep );
+            return true;
+        }
+    }
+    return false;
+}
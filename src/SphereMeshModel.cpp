@@ -151,55 +151,88 @@ void SphereMeshModel::initUnitSphere()
 }
 
 
-void SphereMeshModel::getStaticIndices( uint32_t startIndex, vector<uint32_t> &indices ) 
+void SphereMeshModel::getStaticIndices( uint32_t startIndex, vector<uint32_t> &indices ) const
 {
-    int a, b, c, d, e, f;
+    buildIndices( startIndex, indices, 1 );
+}
+
+
+/*
+** The indices of one sphere only, zero based. A sphere has far less than
+** 64K vertices, so 16 bits are enough; the spheres are drawn from this
+** one list with a base vertex offset each. With decimation > 1 (one of
+** getLodDecimations()) the list is for a coarser sphere on the same vertices.
+*/
+void SphereMeshModel::getStaticIndices( vector<uint16_t> &indices, uint32_t decimation ) const
+{
+    assert( nVertices <= 0xFFFF );
+    assert( nSlices % decimation == 0 && nStacks % decimation == 0 );
+    buildIndices( uint16_t(0), indices, decimation );
+}
+
+
+/*
+** Coarser versions of the sphere (levels of detail) that use the same 
+** vertices: every decimation'th slice and stack. Only the factors that 
+** divide both the slices and the stacks and leave a closed solid qualify.
+*/
+void SphereMeshModel::getLodDecimations( vector<uint32_t> &decimations ) const
+{
+    decimations.clear();
+    for( uint32_t d = 1; d <= nStacks; d++ ) {
+        if( nSlices % d == 0 && nStacks % d == 0 && nSlices / d >= 3 && nStacks / d >= 2 ) {
+            decimations.push_back( d );
+        }
+    }
+}
 
-    for ( uint32_t i = 0; i < nStacks; i++ ) {
-        for ( uint32_t j = 0; j < nSlices; j++ ) {
+
+// First vertex of stack ring "ring" (1..nStacks-1), then slice by slice;
+// vertex 0 is the first pole, nVertices-1 the other one.
+//
+template<typename T>
+void SphereMeshModel::buildIndices( T startIndex, vector<T> &indices, uint32_t decimation ) const
+{
+    uint32_t a, b, c, d, e, f;
+    const uint32_t step = decimation;
+
+    for ( uint32_t i = 0; i < nStacks; i += step ) {
+        for ( uint32_t j = 0; j < nSlices; j += step ) {
+            uint32_t jNext = (j + step < nSlices) ? j + step : 0;
             if( i == 0 ) {
                 a = 0;
-                b = j + 1;
-                c = (j < nSlices-1) ? j + 2 : 1;
-                indices.push_back( startIndex + a );
-                indices.push_back( startIndex + b );
-                indices.push_back( startIndex + c );
-            } else if( i+1 == nStacks ) {
+                b = step*nSlices-(nSlices-1) + j;
+                c = step*nSlices-(nSlices-1) + jNext;
+                indices.push_back( T(startIndex + a) );
+                indices.push_back( T(startIndex + b) );
+                indices.push_back( T(startIndex + c) );
+            } else if( i+step == nStacks ) {
                 a = i*nSlices-(nSlices-1) + j;
-                b = i*nSlices-(nSlices-1) + nSlices;
-                c = (j < nSlices-1) ? i*nSlices-(nSlices-1) + j + 1 : i*nSlices-(nSlices-1);
-                indices.push_back( startIndex + a );
-                indices.push_back( startIndex + b );
-                indices.push_back( startIndex + c );
+                b = nVertices - 1;
+                c = i*nSlices-(nSlices-1) + jNext;
+                indices.push_back( T(startIndex + a) );
+                indices.push_back( T(startIndex + b) );
+                indices.push_back( T(startIndex + c) );
             } else {
-                if( j < nSlices-1 ) {
-                    a =     i*nSlices-(nSlices-1) + j;
-                    b = (i+1)*nSlices-(nSlices-1) + j;
-                    c = (i+1)*nSlices-(nSlices-1) + j + 1;
-                    d = a;
-                    e = c;
-                    f = i*nSlices-(nSlices-1) + j + 1;
-                } else { 
-                    a =     i*nSlices-(nSlices-1) + j;
-                    b = (i+1)*nSlices-(nSlices-1) + j;
-                    c = (i+1)*nSlices-(nSlices-1) + 0 + 0;
-                    d = a;
-                    e = c;
-                    f = i*nSlices-(nSlices-1) + 0 + 0;
-                }
-                indices.push_back( startIndex + a );
-                indices.push_back( startIndex + b );
-                indices.push_back( startIndex + c );
-                indices.push_back( startIndex + d );
-                indices.push_back( startIndex + e );
-                indices.push_back( startIndex + f );
+                a =        i*nSlices-(nSlices-1) + j;
+                b = (i+step)*nSlices-(nSlices-1) + j;
+                c = (i+step)*nSlices-(nSlices-1) + jNext;
+                d = a;
+                e = c;
+                f =        i*nSlices-(nSlices-1) + jNext;
+                indices.push_back( T(startIndex + a) );
+                indices.push_back( T(startIndex + b) );
+                indices.push_back( T(startIndex + c) );
+                indices.push_back( T(startIndex + d) );
+                indices.push_back( T(startIndex + e) );
+                indices.push_back( T(startIndex + f) );
             }
         }
     }
 }
 
 
-void SphereMeshModel::getStaticNormals( vector<Vec3f> &normals ) 
+void SphereMeshModel::getStaticNormals( vector<Vec3f> &normals ) const
 {
     float dRho = PI / (float) nStacks;
     float dTheta = 2.0f * PI / (float) nSlices;
@@ -241,23 +274,13 @@ void SphereMeshModel::getStaticNormals( vector<Vec3f> &normals )
 }
 
 /*
-** Update a VBO from the sphere model.
-** Dynamic position and color; everything else - static.
+** Write the sphere vertex positions straight into a mapped buffer
+** of tightly packed positions; nVertices are written.
 */
-void SphereMeshModel::updateVBO( ci::gl::VboMesh::VertexIter &vertexIter, const Vec3f sphereCenterLocation, const Colorf color) 
+void SphereMeshModel::updatePositions( Vec3f *pPositionsOut, const Vec3f sphereCenterLocation ) const
 {
-    Color effectiveColor = mColor;
-    if( color != Color::black() ) {
-        effectiveColor = color;
-    }
-    Vec3f *pp = pPositions; // unit sphere positions
+    const Vec3f *pp = pPositions; // unit sphere positions
     for( uint32_t i=0; i<nVertices; i++ ) {
-        Vec3f loc = *pp * mRadius;
-        vertexIter.setPosition( sphereCenterLocation + loc );
-        vertexIter.setColorRGB( effectiveColor );
-        // consider setting texture dynamically, too
-        ++pp;
-        ++vertexIter;
+        *pPositionsOut++ = sphereCenterLocation + *pp++ * mRadius;
     }
 }
-
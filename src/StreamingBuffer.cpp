@@ -0,0 +1,140 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ Stall-free streaming vertex buffer; see StreamingBuffer.h.
+*/
+
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Vbo.h"
+#include "cinder/Timer.h"
+
+#include "GlExtensions.h"
+#include "StreamingBuffer.h"
+
+using namespace ci;
+using namespace std;
+
+
+StreamingBuffer::StreamingBuffer() :
+    mMode(MODE_NONE), mIsPersistentAllowed(true), mRegionBytes(0), mRegion(0), mMapped(NULL), mLastWaitTime(0.0)
+{
+    for( size_t i=0; i<STREAMING_REGIONS; i++ ) {
+        mFences[i] = NULL;
+    }
+}
+
+
+StreamingBuffer::~StreamingBuffer()
+{
+    deleteFences();
+}
+
+
+void StreamingBuffer::deleteFences()
+{
+    for( size_t i=0; i<STREAMING_REGIONS; i++ ) {
+        if( mFences[i] != NULL ) {
+            glext::deleteSync( mFences[i] );
+            mFences[i] = NULL;
+        }
+    }
+}
+
+
+// (Re)create the buffer; the persistent ring when the context has what
+// it takes and the caller allows it, the orphaned single region otherwise.
+//
+void StreamingBuffer::init( size_t regionBytes, bool allowPersistent )
+{
+    deleteFences();
+    mIsPersistentAllowed = allowPersistent;
+    mRegionBytes = regionBytes;
+    mRegion = 0;
+    mMapped = NULL;
+    mLastWaitTime = 0.0;
+    if( allowPersistent && glext::hasBufferStorage() && glext::hasSync() ) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        mVbo = gl::Vbo( GL_ARRAY_BUFFER );
+        mVbo.bind();
+        glext::bufferStorage( GL_ARRAY_BUFFER, STREAMING_REGIONS * mRegionBytes, NULL, flags );
+        mMapped = reinterpret_cast<uint8_t*>( glext::mapBufferRange( GL_ARRAY_BUFFER, 0, STREAMING_REGIONS * mRegionBytes, flags ) );
+        mVbo.unbind();
+    }
+    if( mMapped != NULL ) {
+        mMode = MODE_PERSISTENT;
+        mRegion = STREAMING_REGIONS - 1;    // so that the first map() writes region 0
+    } else {
+        // the storage of a failed attempt is immutable; start over with a plain buffer
+        mMode = MODE_ORPHAN;
+        mVbo = gl::Vbo( GL_ARRAY_BUFFER );
+        mVbo.bufferData( mRegionBytes, NULL, GL_STREAM_DRAW );
+        mVbo.unbind();
+    }
+}
+
+
+// Free the buffer (which unmaps it) until the next init().
+//
+void StreamingBuffer::release()
+{
+    deleteFences();
+    mMode = MODE_NONE;
+    mVbo = gl::Vbo();
+    mRegionBytes = 0;
+    mRegion = 0;
+    mMapped = NULL;
+}
+
+
+// The region to write this frame. Persistent: the next one in the ring,
+// once the GPU is done drawing from it. Orphan: fresh storage, mapped.
+//
+uint8_t* StreamingBuffer::map()
+{
+    mLastWaitTime = 0.0;
+    if( mMode == MODE_PERSISTENT ) {
+        mRegion = ( mRegion + 1 ) % STREAMING_REGIONS;
+        if( mFences[mRegion] != NULL ) {
+            if( glext::clientWaitSync( mFences[mRegion], 0, 0 ) == GL_TIMEOUT_EXPIRED ) {
+                Timer timer( true );
+                glext::clientWaitSync( mFences[mRegion], GL_SYNC_FLUSH_COMMANDS_BIT, STREAMING_WAIT_TIMEOUT );
+                mLastWaitTime = timer.getSeconds();
+            }
+            glext::deleteSync( mFences[mRegion] );
+            mFences[mRegion] = NULL;
+        }
+        return mMapped + mRegion * mRegionBytes;
+    }
+    if( mMode == MODE_ORPHAN ) {
+        mVbo.bufferData( mRegionBytes, NULL, GL_STREAM_DRAW );
+        return mVbo.map( GL_WRITE_ONLY );
+    }
+    return NULL;
+}
+
+
+void StreamingBuffer::unmap()
+{
+    // a coherent mapping stays; the writes are visible to the draws that follow
+    if( mMode == MODE_ORPHAN ) {
+        mVbo.unmap();
+        mVbo.unbind();
+    }
+}
+
+
+// Mark the end of the draws from the current region. It may be drawn
+// again in the following frames (when nothing changed); the fence then
+// follows the last of them.
+//
+void StreamingBuffer::fence()
+{
+    if( mMode != MODE_PERSISTENT ) return;
+    if( mFences[mRegion] != NULL ) {
+        glext::deleteSync( mFences[mRegion] );
+    }
+    mFences[mRegion] = glext::fenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+}
@@ -0,0 +1,197 @@
+/*
+ Copyright (C)2013 Stefan Ganev, https://github.com/stefan-g/
+ All rights reserved. Licensed under the BSD 2-Clause License;
+ see License.txt and http://opensource.org/licenses/BSD-2-Clause.
+
+ Trajectory drawn as a swept tube; see TubeMesh.h.
+*/
+
+#include "cinder/Cinder.h"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Vbo.h"
+#include "cinder/Color.h"
+#include "cinder/Vector.h"
+#include <vector>
+#include <algorithm>
+#include <stddef.h>
+#include <math.h>
+
+#include "TubeMesh.h"
+
+using namespace ci;
+using namespace std;
+
+
+// Build the static indices for maxRings rings and allocate the vertices
+//
+void TubeMesh::init( size_t maxRings, uint32_t segments, float radius )
+{
+    mMaxRings = maxRings;
+    mNumRings = 0;
+    mSegments = segments;
+    mRadius = radius;
+    mPoints.clear();
+    mSteps.clear();
+    mTangents.resize( mMaxRings );
+    mFrameNormals.resize( mMaxRings );
+    mVertices.resize( mMaxRings * mSegments );
+    mRing.resize( mSegments );
+    for( uint32_t j=0; j<mSegments; j++ ) {
+        float a = 2.0f * 3.14159265f * float(j) / float(mSegments);
+        mRing[j] = Vec2f( cos(a), sin(a) );
+    }
+    if( mStepColors.empty() ) {
+        mStepColors.assign( 1, ColorA8u( 255, 255, 255, 255 ) );
+    }
+
+    // Two triangles per segment between neighbor rings
+    vector<uint32_t> indices;
+    indices.reserve( 6 * mSegments * (mMaxRings > 0 ? mMaxRings-1 : 0) );
+    for( uint32_t i=0; i+1<mMaxRings; i++ ) {
+        for( uint32_t j=0; j<mSegments; j++ ) {
+            uint32_t a = i * mSegments + j;
+            uint32_t b = i * mSegments + (j+1) % mSegments;
+            indices.push_back( a );
+            indices.push_back( a + mSegments );
+            indices.push_back( b );
+            indices.push_back( b );
+            indices.push_back( a + mSegments );
+            indices.push_back( b + mSegments );
+        }
+    }
+    mIndexVbo = gl::Vbo( GL_ELEMENT_ARRAY_BUFFER );
+    if( mVertices.size() <= 0x10000 ) {
+        vector<uint16_t> indices16( indices.begin(), indices.end() );
+        mIndexType = GL_UNSIGNED_SHORT;
+        mIndexVbo.bufferData( indices16.size() * sizeof(uint16_t), indices16.empty() ? NULL : &indices16[0], GL_STATIC_DRAW );
+    } else {
+        mIndexType = GL_UNSIGNED_INT;
+        mIndexVbo.bufferData( indices.size() * sizeof(uint32_t), &indices[0], GL_STATIC_DRAW );
+    }
+    mIndexVbo.unbind();
+
+    mVertexVbo = gl::Vbo( GL_ARRAY_BUFFER );
+    mVertexVbo.bufferData( mVertices.size() * sizeof(Vertex), NULL, GL_DYNAMIC_DRAW );
+    mVertexVbo.unbind();
+}
+
+
+// The ring color for each step; a change rebuilds the whole tube
+//
+void TubeMesh::setStepColors( const vector<Colorf> &colors )
+{
+    mStepColors.resize( colors.size() );
+    for( size_t i=0; i<colors.size(); i++ ) {
+        mStepColors[i] = ColorA8u( uint8_t(colors[i].r*255.0f), uint8_t(colors[i].g*255.0f), uint8_t(colors[i].b*255.0f), 255 );
+    }
+    mPoints.clear();
+    mSteps.clear();
+}
+
+
+// Rebuild and upload the rings from the first point that differs from
+// the last update() on. The ring before it is rebuilt too: its tangent
+// is taken towards the next point.
+//
+void TubeMesh::update( const vector<Vec3f> &points, const vector<uint32_t> &steps )
+{
+    size_t n = min( points.size(), mMaxRings );
+    size_t first = 0;
+    size_t same = min( n, mPoints.size() );
+    while( first < same && points[first] == mPoints[first]
+           && ( steps.empty() ? uint32_t(first) : steps[first] ) == mSteps[first] ) {
+        first++;
+    }
+    mLastUploadBytes = 0;
+    if( first == n && n == mNumRings ) return;
+    if( first > 0 ) first--;
+
+    mPoints.assign( points.begin(), points.begin() + n );
+    mSteps.resize( n );
+    for( size_t i=0; i<n; i++ ) {
+        mSteps[i] = steps.empty() ? uint32_t(i) : steps[i];
+    }
+    mNumRings = n;
+    if( first >= n ) return;
+    buildRings( first );
+
+    size_t offset = first * mSegments;
+    size_t count = (n - first) * mSegments;
+    mVertexVbo.bufferSubData( offset * sizeof(Vertex), count * sizeof(Vertex), &mVertices[offset] );
+    mVertexVbo.unbind();
+    mLastUploadBytes = count * sizeof(Vertex);
+}
+
+
+// Parallel transport by double reflection (Wang et al., "Computation of
+// rotation minimizing frames", 2008): the frame normal of ring i-1 is
+// reflected across the bisector plane of the two points, then across the
+// plane that maps the reflected tangent onto the new one.
+//
+void TubeMesh::buildRings( size_t first )
+{
+    for( size_t i=first; i<mNumRings; i++ ) {
+        Vec3f t = mPoints[ i+1 < mNumRings ? i+1 : i ] - mPoints[ i > 0 ? i-1 : i ];
+        float len = t.length();
+        if( len > 0.0f ) {
+            t /= len;
+        } else {
+            t = ( i > 0 ) ? mTangents[i-1] : Vec3f::zAxis();
+        }
+        Vec3f n;
+        if( i == 0 ) {
+            n = ( fabs(t.x) < 0.9f ) ? Vec3f::xAxis() : Vec3f::yAxis();
+        } else {
+            n = mFrameNormals[i-1];
+            Vec3f tPrev = mTangents[i-1];
+            Vec3f v1 = mPoints[i] - mPoints[i-1];
+            float c1 = v1.dot( v1 );
+            if( c1 > 0.0f ) {
+                n -= v1 * ( 2.0f / c1 * v1.dot( n ) );
+                tPrev -= v1 * ( 2.0f / c1 * v1.dot( tPrev ) );
+            }
+            Vec3f v2 = t - tPrev;
+            float c2 = v2.dot( v2 );
+            if( c2 > 0.0f ) {
+                n -= v2 * ( 2.0f / c2 * v2.dot( n ) );
+            }
+        }
+        n -= t * t.dot( n );    // keep the frame orthonormal against round-off
+        n.normalize();
+        Vec3f b = t.cross( n );
+        mTangents[i] = t;
+        mFrameNormals[i] = n;
+
+        ColorA8u color = mStepColors[ min( size_t(mSteps[i]), mStepColors.size()-1 ) ];
+        Vertex *v = &mVertices[i * mSegments];
+        for( uint32_t j=0; j<mSegments; j++, v++ ) {
+            Vec3f dir = n * mRing[j].x + b * mRing[j].y;
+            v->mPosition = mPoints[i] + dir * mRadius;
+            v->mNormal = dir;
+            v->mColor = color;
+        }
+    }
+}
+
+
+// Draw the tube through the first numRings points
+//
+void TubeMesh::draw( size_t numRings )
+{
+    numRings = min( numRings, mNumRings );
+    if( numRings < 2 ) return;
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_NORMAL_ARRAY );
+    glEnableClientState( GL_COLOR_ARRAY );
+    mVertexVbo.bind();
+    glVertexPointer( 3, GL_FLOAT, sizeof(Vertex), (const GLvoid*) offsetof(Vertex, mPosition) );
+    glNormalPointer( GL_FLOAT, sizeof(Vertex), (const GLvoid*) offsetof(Vertex, mNormal) );
+    glColorPointer( 4, GL_UNSIGNED_BYTE, sizeof(Vertex), (const GLvoid*) offsetof(Vertex, mColor) );
+    mIndexVbo.bind();
+    glDrawElements( GL_TRIANGLES, GLsizei( 6 * mSegments * (numRings-1) ), mIndexType, 0 );
+    mIndexVbo.unbind();
+    mVertexVbo.unbind();
+    glDisableClientState( GL_VERTEX_ARRAY );
+    glDisableClientState( GL_NORMAL_ARRAY );
+    glDisableClientState( GL_COLOR_ARRAY );
+}